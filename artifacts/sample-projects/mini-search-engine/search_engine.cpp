@@ -1,164 +1,1975 @@
 #include "cpp-template.h"
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
 
 // Mini Search Engine using Trie and Hash Map
 // Demonstrates practical use of data structures
+// The Trie used for suggestions is the arena-backed one from cpp-template.h
 
-struct TrieNode {
-    TrieNode* children[26];
-    bool isEnd;
-    vector<string> suggestions;
+// Column
+// Read-only array that either owns its elements (while an index is being
+// built) or borrows them from a memory-mapped index segment.
+template<typename T>
+class Column {
+    vector<T> owned;
+    const T* borrowed = nullptr;
+    size_t borrowedSize = 0;
+    bool isBorrowed = false;
     
-    TrieNode() : isEnd(false) {
-        for (int i = 0; i < 26; i++) {
-            children[i] = nullptr;
+public:
+    Column() = default;
+    Column(size_t n, const T& value) : owned(n, value) {}
+    Column(const T* data, size_t size) 
+        : borrowed(data), borrowedSize(size), isBorrowed(true) {}
+    
+    vector<T>& vec() { return owned; } // for building; empty when borrowed
+    const T* data() const { return isBorrowed ? borrowed : owned.data(); }
+    size_t size() const { return isBorrowed ? borrowedSize : owned.size(); }
+    const T& operator[](size_t i) const { return data()[i]; }
+    const T& back() const { return data()[size() - 1]; }
+};
+
+// Posting List
+// Sorted doc IDs, delta-encoded as varints and grouped into fixed-size blocks,
+// with each posting's term frequency in a parallel varint stream and its token
+// positions (delta-encoded, freq of them) in a third. Every block records its
+// last doc ID and stream offsets (skip pointers), so an iterator can jump over
+// whole blocks without decoding them, plus the largest term frequency and
+// shortest document it holds, which bound any score inside it.
+struct PostingBlock {
+    uint32_t lastDocId;
+    uint32_t offset;
+    uint32_t freqOffset;
+    uint32_t posOffset;
+    uint32_t maxFreq;
+    uint32_t minDocLength;
+};
+
+// Read-only view of one encoded posting list, in memory or in a mapped segment
+struct PostingView {
+    static constexpr int BLOCK_SIZE = 128;
+    
+    const uint8_t* data = nullptr;
+    const uint8_t* freqData = nullptr;
+    const uint8_t* posData = nullptr;
+    const PostingBlock* blocks = nullptr;
+    uint32_t blockCount = 0;
+    uint32_t count = 0;
+    
+    size_t size() const { return count; }
+    
+    // Forward iterator that decodes one block at a time, on demand; term
+    // frequencies of a block are only decoded if freq() is called, and
+    // positions only for the postings positions() is called on.
+    class Iterator {
+        const uint8_t* data;
+        const uint8_t* freqData;
+        const uint8_t* posData;
+        const PostingBlock* blocks;
+        uint32_t listBlocks, listCount;
+        uint32_t block;
+        int pos, blockCount;
+        bool freqsDecoded;
+        const uint8_t* posCursor; // positions of posting posIndex in the block
+        int posIndex;
+        uint32_t buffer[BLOCK_SIZE];
+        uint32_t freqs[BLOCK_SIZE];
+        
+    public:
+        explicit Iterator(const PostingView& list) 
+            : data(list.data), freqData(list.freqData), posData(list.posData), blocks(list.blocks),
+              listBlocks(list.blockCount), listCount(list.count),
+              block(0), pos(0), blockCount(0), freqsDecoded(false) {
+            if (listBlocks > 0) decodeBlock(0);
+        }
+        
+        bool valid() const { return block < listBlocks; }
+        int docId() const { return buffer[pos]; }
+        
+        uint32_t freq() {
+            if (!freqsDecoded) decodeFreqs();
+            return freqs[pos];
+        }
+        
+        // Token positions of the current document, ascending. Skips forward
+        // over the positions of earlier postings in the block without storing them.
+        void positions(vector<uint32_t>& out) {
+            if (!freqsDecoded) decodeFreqs();
+            if (posIndex > pos) {
+                posCursor = posData + blocks[block].posOffset;
+                posIndex = 0;
+            }
+            for (; posIndex < pos; posIndex++) {
+                for (uint32_t i = 0; i < freqs[posIndex]; i++) {
+                    while (*posCursor++ & 0x80) {}
+                }
+            }
+            
+            out.resize(freqs[pos]);
+            uint32_t position = 0;
+            for (uint32_t i = 0; i < freqs[pos]; i++) {
+                position += readVarint(posCursor);
+                out[i] = position;
+            }
+            posIndex++;
+        }
+        
+        void next() {
+            if (++pos < blockCount) return;
+            if (++block < listBlocks) decodeBlock(block);
+        }
+        
+        // Move to the first doc ID >= target. Gallops over the skip pointers
+        // and then inside the block, so large jumps cost O(log distance).
+        void advance(int target) {
+            if (!valid() || docId() >= target) return;
+            
+            uint32_t t = target;
+            if (blocks[block].lastDocId < t) {
+                block = findBlock(t);
+                if (!valid()) return;
+                decodeBlock(block);
+            }
+            
+            int lo = pos, hi = pos, step = 1;
+            while (hi < blockCount && buffer[hi] < t) {
+                lo = hi;
+                hi += step;
+                step <<= 1;
+            }
+            pos = lower_bound(buffer + lo, buffer + min(hi, blockCount), t) - buffer;
+        }
+        
+        // Block that would hold the first doc ID >= target, without moving or
+        // decoding anything; nullptr if the list ends before target.
+        const PostingBlock* peekBlock(int target) const {
+            if (!valid()) return nullptr;
+            uint32_t t = target;
+            uint32_t b = blocks[block].lastDocId >= t ? block : findBlock(t);
+            return b < listBlocks ? &blocks[b] : nullptr;
+        }
+        
+    private:
+        // First block after the current one whose last doc ID is >= t
+        uint32_t findBlock(uint32_t t) const {
+            uint32_t n = listBlocks;
+            uint32_t lo = block + 1, hi = lo, step = 1;
+            while (hi < n && blocks[hi].lastDocId < t) {
+                lo = hi + 1;
+                hi += step;
+                step <<= 1;
+            }
+            hi = min(hi, n);
+            return partition_point(blocks + lo, blocks + hi, [t](const PostingBlock& b) {
+                return b.lastDocId < t;
+            }) - blocks;
+        }
+        
+        void decodeBlock(uint32_t b) {
+            const uint8_t* p = data + blocks[b].offset;
+            uint32_t prev = b == 0 ? 0 : blocks[b - 1].lastDocId;
+            blockCount = min<uint32_t>(BLOCK_SIZE, listCount - b * BLOCK_SIZE);
+            for (int i = 0; i < blockCount; i++) {
+                prev += readVarint(p);
+                buffer[i] = prev;
+            }
+            pos = 0;
+            freqsDecoded = false;
+            posCursor = posData + blocks[b].posOffset;
+            posIndex = 0;
+        }
+        
+        void decodeFreqs() {
+            const uint8_t* p = freqData + blocks[block].freqOffset;
+            for (int i = 0; i < blockCount; i++) {
+                freqs[i] = readVarint(p);
+            }
+            freqsDecoded = true;
+        }
+    };
+    
+    Iterator iterator() const { return Iterator(*this); }
+    
+    vector<int> decode() const {
+        vector<int> result;
+        decodeInto(result);
+        return result;
+    }
+    
+    // Decodes into a caller-owned buffer so repeated queries reuse its capacity.
+    void decodeInto(vector<int>& out) const {
+        out.clear();
+        out.reserve(count);
+        for (Iterator it = iterator(); it.valid(); it.next()) {
+            out.push_back(it.docId());
         }
     }
+    
+    static uint32_t readVarint(const uint8_t*& p) {
+        uint32_t value = 0;
+        int shift = 0;
+        while (*p & 0x80) {
+            value |= (uint32_t)(*p++ & 0x7F) << shift;
+            shift += 7;
+        }
+        value |= (uint32_t)(*p++) << shift;
+        return value;
+    }
 };
 
-class Trie {
-    TrieNode* root;
+class PostingList {
+public:
+    static constexpr int BLOCK_SIZE = PostingView::BLOCK_SIZE;
+    
+private:
+    vector<uint8_t> data;
+    vector<uint8_t> freqData;
+    vector<uint8_t> posData;
+    vector<PostingBlock> blocks;
+    uint32_t count = 0;
     
 public:
-    Trie() : root(new TrieNode()) {}
+    // Doc IDs must arrive in non-decreasing order; returns false for a repeat,
+    // which is ignored (callers aggregate a document's occurrences first).
+    // positions holds the freq token positions of the term, ascending.
+    // An unknown docLength of 0 only makes the block's score bound looser.
+    bool add(int docId, const uint32_t* positions, uint32_t freq, uint32_t docLength = 0) {
+        uint32_t id = docId;
+        if (count > 0 && id == blocks.back().lastDocId) return false;
+        
+        uint32_t prev = 0;
+        if (count % BLOCK_SIZE == 0) {
+            if (!blocks.empty()) prev = blocks.back().lastDocId;
+            blocks.push_back({id, (uint32_t)data.size(), (uint32_t)freqData.size(),
+                              (uint32_t)posData.size(), 0, UINT32_MAX});
+        } else {
+            prev = blocks.back().lastDocId;
+        }
+        
+        writeVarint(data, id - prev);
+        writeVarint(freqData, freq);
+        for (uint32_t i = 0, last = 0; i < freq; i++) {
+            writeVarint(posData, positions[i] - last);
+            last = positions[i];
+        }
+        PostingBlock& block = blocks.back();
+        block.lastDocId = id;
+        block.maxFreq = max(block.maxFreq, freq);
+        block.minDocLength = min(block.minDocLength, docLength);
+        count++;
+        return true;
+    }
     
-    void insert(const string& word) {
-        TrieNode* node = root;
-        for (char c : word) {
-            int index = c - 'a';
-            if (!node->children[index]) {
-                node->children[index] = new TrieNode();
-            }
-            node = node->children[index];
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t memoryUsage() const {
+        return data.capacity() + freqData.capacity() + posData.capacity() +
+               blocks.capacity() * sizeof(PostingBlock);
+    }
+    
+    // Only valid until the next add()
+    PostingView view() const {
+        return {data.data(), freqData.data(), posData.data(), blocks.data(), (uint32_t)blocks.size(), count};
+    }
+    
+    vector<int> decode() const { return view().decode(); }
+    
+    const vector<uint8_t>& bytes() const { return data; }
+    const vector<uint8_t>& freqBytes() const { return freqData; }
+    const vector<uint8_t>& positionBytes() const { return posData; }
+    const vector<PostingBlock>& skipBlocks() const { return blocks; }
+    
+private:
+    static void writeVarint(vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back((value & 0x7F) | 0x80);
+            value >>= 7;
         }
-        node->isEnd = true;
+        out.push_back(value);
     }
+};
+
+// Tokenizer
+// Lowercases the whole document into a reusable buffer and returns tokens as
+// string_views into it (valid until the next call). Tokens are runs of ASCII
+// letters, digits and non-ASCII bytes, so UTF-8 words stay whole; every other
+// ASCII byte separates tokens. Bytes are classified and ASCII letters
+// lowercased 16 at a time.
+class Tokenizer {
+    string buffer;
+    vector<string_view> tokens;
     
-    vector<string> getSuggestions(const string& prefix) {
-        TrieNode* node = root;
-        vector<string> result;
+public:
+    const vector<string_view>& tokenize(string_view doc) {
+        size_t n = doc.size();
+        buffer.resize(n);
+        tokens.clear();
+        
+        const char* in = doc.data();
+        char* out = buffer.data();
+        size_t start = 0;
+        bool inToken = false;
+        size_t i = 0;
         
-        // Navigate to prefix
-        for (char c : prefix) {
-            int index = c - 'a';
-            if (!node->children[index]) {
-                return result; // No suggestions found
+#ifdef __SSE2__
+        const __m128i caseBit = _mm_set1_epi8(0x20);
+        const __m128i shift = _mm_set1_epi8(char(0x80 - 'a'));
+        const __m128i limit = _mm_set1_epi8(char(0x80 + 26));
+        const __m128i digitShift = _mm_set1_epi8(char(0x80 - '0'));
+        const __m128i digitLimit = _mm_set1_epi8(char(0x80 + 10));
+        
+        for (; i + 16 <= n; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+            __m128i lower = _mm_or_si128(v, caseBit);
+            // (c | 0x20) in ['a', 'z'], as a signed compare after shifting 'a' to -128
+            __m128i alpha = _mm_cmplt_epi8(_mm_add_epi8(lower, shift), limit);
+            __m128i folded = _mm_or_si128(_mm_and_si128(alpha, lower), _mm_andnot_si128(alpha, v));
+            _mm_storeu_si128((__m128i*)(out + i), folded);
+            
+            // Non-ASCII bytes have the sign bit set, so v itself contributes them
+            __m128i digit = _mm_cmplt_epi8(_mm_add_epi8(v, digitShift), digitLimit);
+            uint32_t mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), v));
+            uint32_t before = (mask << 1) | (inToken ? 1 : 0);
+            uint32_t starts = mask & ~before;
+            uint32_t ends = ~mask & before & 0xFFFF;
+            
+            while (starts | ends) {
+                uint32_t next = (starts | ends) & -(starts | ends);
+                size_t pos = i + __builtin_ctz(next);
+                if (starts & next) {
+                    start = pos;
+                    starts ^= next;
+                } else {
+                    tokens.emplace_back(out + start, pos - start);
+                    ends ^= next;
+                }
+            }
+            inToken = mask & 0x8000;
+        }
+#endif
+        
+        for (; i < n; i++) {
+            char c = in[i];
+            bool alpha = uint8_t((c | 0x20) - 'a') < 26;
+            bool word = alpha || uint8_t(c - '0') < 10 || uint8_t(c) >= 0x80;
+            out[i] = alpha ? (c | 0x20) : c;
+            
+            if (word && !inToken) {
+                start = i;
+            } else if (!word && inToken) {
+                tokens.emplace_back(out + start, i - start);
             }
-            node = node->children[index];
+            inToken = word;
+        }
+        
+        if (inToken) {
+            tokens.emplace_back(out + start, n - start);
+        }
+        return tokens;
+    }
+};
+
+// Term Dictionary
+// Interns each distinct term once: characters are stored back to back in a
+// single pool and looked up through an open-addressing table of term IDs.
+// The hash is FNV-1a rather than std::hash so the table can be persisted.
+class TermDictionary {
+    Column<char> pool;
+    Column<uint32_t> offsets; // term ID -> start in pool (plus one end marker)
+    Column<uint32_t> table;   // term IDs, NONE marks an empty slot
+    
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+    
+    TermDictionary() : offsets(1, 0), table(16, NONE) {}
+    TermDictionary(Column<char> pool, Column<uint32_t> offsets, Column<uint32_t> table)
+        : pool(pool), offsets(offsets), table(table) {}
+    
+    uint32_t find(string_view term) const {
+        return table[slotOf(term)];
+    }
+    
+    uint32_t intern(string_view term) {
+        size_t slot = slotOf(term);
+        if (table[slot] != NONE) return table[slot];
+        
+        uint32_t id = size();
+        pool.vec().insert(pool.vec().end(), term.begin(), term.end());
+        offsets.vec().push_back(pool.size());
+        table.vec()[slot] = id;
+        
+        if (size() * 2 > table.size()) grow();
+        return id;
+    }
+    
+    string_view term(uint32_t id) const {
+        return string_view(pool.data() + offsets[id], offsets[id + 1] - offsets[id]);
+    }
+    
+    size_t size() const { return offsets.size() - 1; }
+    
+    const Column<char>& poolColumn() const { return pool; }
+    const Column<uint32_t>& offsetColumn() const { return offsets; }
+    const Column<uint32_t>& tableColumn() const { return table; }
+    
+private:
+    static uint64_t hashTerm(string_view term) {
+        uint64_t h = 1469598103934665603ULL;
+        for (char c : term) {
+            h = (h ^ uint8_t(c)) * 1099511628211ULL;
+        }
+        return h;
+    }
+    
+    // First slot holding the term, or the empty slot where it would go
+    size_t slotOf(string_view term) const {
+        size_t mask = table.size() - 1;
+        size_t slot = hashTerm(term) & mask;
+        while (table[slot] != NONE && this->term(table[slot]) != term) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+    
+    void grow() {
+        vector<uint32_t> old(table.size() * 2, NONE);
+        table.vec().swap(old);
+        for (uint32_t id : old) {
+            if (id != NONE) table.vec()[slotOf(term(id))] = id;
+        }
+    }
+};
+
+// Ranked Suggestions
+// Every trie node keeps its K best completions in a fixed slot of one flat
+// array, ordered by score (document frequency) and then alphabetically.
+// Scores only grow, so each update just fixes the lists along one path and a
+// prefix query costs O(prefix length + K) however many words lie below it.
+class TopKSuggestions {
+public:
+    static constexpr int K = 8;
+    
+    struct Entry {
+        uint32_t score;
+        uint32_t termId;
+    };
+    
+private:
+    Column<Entry> entries;  // K slots per trie node
+    Column<uint8_t> counts; // used slots per trie node
+    
+public:
+    TopKSuggestions() = default;
+    TopKSuggestions(Column<Entry> entries, Column<uint8_t> counts)
+        : entries(entries), counts(counts) {}
+    
+    const Column<Entry>& entryColumn() const { return entries; }
+    const Column<uint8_t>& countColumn() const { return counts; }
+    
+    // Inserts the term into the trie if needed and raises its score.
+    void update(Trie& trie, const TermDictionary& terms, uint32_t termId, uint32_t score) {
+        string_view word = terms.term(termId);
+        trie.insert(word);
+        if (trie.size() > counts.size()) {
+            entries.vec().resize(trie.size() * K);
+            counts.vec().resize(trie.size(), 0);
         }
         
-        // Collect all words with this prefix
-        collectWords(node, prefix, result);
+        Entry entry = {score, termId};
+        uint32_t node = Trie::ROOT;
+        updateNode(terms, node, entry);
+        for (char c : word) {
+            node = trie.child(node, c);
+            updateNode(terms, node, entry);
+        }
+    }
+    
+    // Moves each node's list to its new ID after Trie::freeze()
+    void remap(const vector<uint32_t>& newIds) {
+        Column<Entry> moved(newIds.size() * K, Entry{});
+        Column<uint8_t> movedCounts(newIds.size(), 0);
+        for (uint32_t node = 0; node < newIds.size() && node < counts.size(); node++) {
+            uint32_t to = newIds[node];
+            copy(&entries[node * K], &entries[node * K] + K, &moved.vec()[to * K]);
+            movedCounts.vec()[to] = counts[node];
+        }
+        entries = move(moved);
+        counts = move(movedCounts);
+    }
+    
+    vector<string> top(const Trie& trie, const TermDictionary& terms,
+                       const string& prefix, int k) const {
+        vector<string> result;
+        uint32_t node = trie.walk(prefix);
+        if (node == Trie::NONE || node >= counts.size()) return result;
+        
+        int n = min<int>(k, counts[node]);
+        for (int i = 0; i < n; i++) {
+            result.emplace_back(terms.term(entries[node * K + i].termId));
+        }
         return result;
     }
     
 private:
-    void collectWords(TrieNode* node, const string& prefix, vector<string>& result) {
-        if (node->isEnd) {
-            result.push_back(prefix);
+    static bool better(const TermDictionary& terms, const Entry& a, const Entry& b) {
+        if (a.score != b.score) return a.score > b.score;
+        return terms.term(a.termId) < terms.term(b.termId);
+    }
+    
+    void updateNode(const TermDictionary& terms, uint32_t node, const Entry& entry) {
+        Entry* list = &entries.vec()[node * K];
+        int n = counts[node];
+        
+        int i = 0;
+        while (i < n && list[i].termId != entry.termId) i++;
+        if (i == n) {
+            if (n < K) {
+                counts.vec()[node]++;
+            } else if (better(terms, entry, list[K - 1])) {
+                i = K - 1;
+            } else {
+                return;
+            }
+        }
+        
+        list[i] = entry;
+        while (i > 0 && better(terms, list[i], list[i - 1])) {
+            swap(list[i], list[i - 1]);
+            i--;
         }
+    }
+};
+
+// Intersection kernels for sorted, duplicate-free doc ID arrays.
+namespace intersection {
+    // Block-wise all-pairs compare (4x4 lanes per step) with a scalar tail.
+    // `out` must have room for min(na, nb) entries; returns the match count.
+    size_t simd(const int* a, size_t na, const int* b, size_t nb, int* out) {
+        size_t i = 0, j = 0, k = 0;
+        
+#ifdef __SSE2__
+        size_t na4 = na & ~size_t(3), nb4 = nb & ~size_t(3);
+        while (i < na4 && j < nb4) {
+            __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+            
+            __m128i eq0 = _mm_cmpeq_epi32(va, vb);
+            __m128i eq1 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)));
+            __m128i eq2 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2)));
+            __m128i eq3 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)));
+            __m128i eq = _mm_or_si128(_mm_or_si128(eq0, eq1), _mm_or_si128(eq2, eq3));
+            
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+            while (mask) {
+                out[k++] = a[i + __builtin_ctz(mask)];
+                mask &= mask - 1;
+            }
+            
+            int maxA = a[i + 3], maxB = b[j + 3];
+            if (maxA <= maxB) i += 4;
+            if (maxB <= maxA) j += 4;
+        }
+#endif
+        
+        while (i < na && j < nb) {
+            if (a[i] == b[j]) {
+                out[k++] = a[i];
+                i++;
+                j++;
+            } else if (a[i] < b[j]) {
+                i++;
+            } else {
+                j++;
+            }
+        }
+        
+        return k;
+    }
+    
+    // Probes a (much longer) posting list for each candidate via skip pointers.
+    void galloping(const vector<int>& candidates, const PostingView& list, vector<int>& out) {
+        out.clear();
+        PostingView::Iterator it = list.iterator();
         
-        for (int i = 0; i < 26; i++) {
-            if (node->children[i]) {
-                char c = 'a' + i;
-                collectWords(node->children[i], prefix + c, result);
+        for (int docId : candidates) {
+            it.advance(docId);
+            if (!it.valid()) break;
+            if (it.docId() == docId) {
+                out.push_back(docId);
             }
         }
     }
+}
+
+// BM25 scoring
+// A term's contribution grows with its frequency in the document and shrinks
+// with document length, so (max frequency, min length) over a block bounds
+// every score inside that block.
+namespace bm25 {
+    constexpr double K1 = 1.2;
+    constexpr double B = 0.75;
+    
+    double idf(size_t documentCount, size_t documentFrequency) {
+        double n = documentCount, df = documentFrequency;
+        return log(1.0 + (n - df + 0.5) / (df + 0.5));
+    }
+    
+    double score(double idf, uint32_t freq, uint32_t docLength, double avgLength) {
+        double norm = K1 * (1.0 - B + B * docLength / avgLength);
+        return idf * freq * (K1 + 1.0) / (freq + norm);
+    }
+    
+    double blockBound(double idf, const PostingBlock& block, double avgLength) {
+        return score(idf, block.maxFreq, block.minDocLength, avgLength);
+    }
+}
+
+// Index Segment
+// Versioned, read-only on-disk image of an engine. A fixed header lists the
+// byte range of every section; sections are 8-byte aligned arrays in host
+// byte order, laid out exactly like the in-memory columns, so an opened
+// segment is served straight from the mapping without deserialization.
+namespace segment {
+    constexpr char MAGIC[8] = {'M', 'S', 'E', 'I', 'D', 'X', '\0', '\0'};
+    constexpr uint32_t VERSION = 4;
+    
+    enum Section : uint32_t {
+        TERM_POOL, TERM_OFFSETS, TERM_TABLE,
+        POSTING_TERMS, POSTING_DATA, POSTING_FREQS, POSTING_POSITIONS, POSTING_BLOCKS,
+        TRIE_NODES, TRIE_SLOTS,
+        SUGGESTION_ENTRIES, SUGGESTION_COUNTS,
+        DOC_OFFSETS, DOC_DATA, DOC_LENGTHS,
+        STATS,
+        SECTION_COUNT
+    };
+    
+    struct Range {
+        uint64_t offset;
+        uint64_t size; // in bytes
+    };
+    
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t sectionCount;
+        Range sections[SECTION_COUNT];
+    };
+    
+    // Where one term's postings start inside the POSTING_* sections
+    struct TermPostings {
+        uint64_t dataOffset;
+        uint64_t freqOffset;
+        uint64_t posOffset;
+        uint32_t firstBlock;
+        uint32_t count;
+    };
+    
+    struct Stats {
+        uint64_t documentCount;
+        uint64_t totalLength; // tokens over all documents, for BM25's average length
+    };
+    
+    // Typed view of a section, or nullopt if the header points outside the file
+    template<typename T>
+    optional<Column<T>> section(const MappedFile& file, const Header& header, Section s) {
+        Range r = header.sections[s];
+        if (r.offset % 8 != 0 || r.size % sizeof(T) != 0 ||
+            r.offset > file.size() || r.size > file.size() - r.offset) {
+            return nullopt;
+        }
+        return Column<T>((const T*)(file.data() + r.offset), r.size / sizeof(T));
+    }
+    
+    // Streams sections to a file, then patches the header with their ranges
+    class Writer {
+        ofstream out;
+        Header header;
+        Section current = SECTION_COUNT;
+        
+    public:
+        explicit Writer(const string& path) : out(path, ios::binary | ios::trunc), header() {
+            memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.sectionCount = SECTION_COUNT;
+            out.write((const char*)&header, sizeof(header));
+        }
+        
+        void begin(Section s) {
+            static const char zeros[8] = {};
+            out.write(zeros, (8 - out.tellp() % 8) % 8);
+            header.sections[s] = {(uint64_t)out.tellp(), 0};
+            current = s;
+        }
+        
+        template<typename T>
+        void append(const T* data, size_t count) {
+            out.write((const char*)data, count * sizeof(T));
+            header.sections[current].size += count * sizeof(T);
+        }
+        
+        template<typename T>
+        void write(Section s, const T* data, size_t count) {
+            begin(s);
+            append(data, count);
+        }
+        
+        bool finish() {
+            out.seekp(0);
+            out.write((const char*)&header, sizeof(header));
+            out.flush();
+            return out.good();
+        }
+    };
+}
+
+// Query Result Cache
+// Bounded LRU cache split into shards, each with its own lock, so concurrent
+// readers rarely contend. Values are immutable and shared: a hit only copies
+// a shared_ptr under the shard lock, and the caller reads the result after
+// releasing it, so a long result never holds up other readers of its shard.
+// The bound is a byte budget split evenly across the shards; a value larger
+// than its shard's budget is not cached, so one huge result cannot flush the
+// rest. Entries are tagged with the index generation they were computed at
+// and a lookup at any other generation is a miss, so a writer invalidates
+// every cached result by bumping a single counter.
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t capacity = 0; // in bytes
+    
+    double hitRate() const {
+        return hits + misses == 0 ? 0.0 : (double)hits / (hits + misses);
+    }
+};
+
+// Approximate memory held by a cached value, charged against the byte budget
+size_t cacheBytes(const vector<int>& value) {
+    return sizeof(value) + value.size() * sizeof(int);
+}
+
+size_t cacheBytes(const vector<string>& value) {
+    size_t bytes = sizeof(value) + value.size() * sizeof(string);
+    for (const string& s : value) bytes += s.size();
+    return bytes;
+}
+
+template<typename V>
+class QueryCache {
+    struct Entry {
+        string key;
+        uint64_t generation;
+        shared_ptr<const V> value;
+        size_t bytes;
+    };
+    
+    struct Shard {
+        mutex lock;
+        list<Entry> entries; // most recently used first
+        unordered_map<string_view, typename list<Entry>::iterator> index; // keys point into entries
+        uint64_t hits = 0, misses = 0;
+        size_t bytes = 0;
+        size_t capacity = 0; // guarded by lock, so setCapacity can race with lookups
+    };
+    
+    static constexpr size_t SHARDS = 16;
+    unique_ptr<Shard[]> shards;
+    
+public:
+    explicit QueryCache(size_t capacity) : shards(new Shard[SHARDS]) {
+        setCapacity(capacity);
+    }
+    
+    // Capacity is in bytes; 0 disables the cache. Drops current entries.
+    void setCapacity(size_t capacity) {
+        size_t shardCapacity = (capacity + SHARDS - 1) / SHARDS;
+        for (size_t i = 0; i < SHARDS; i++) {
+            lock_guard<mutex> lock(shards[i].lock);
+            shards[i].capacity = shardCapacity;
+            shards[i].index.clear();
+            shards[i].entries.clear();
+            shards[i].bytes = 0;
+        }
+    }
+    
+    // The value cached for key at this generation, or null on a miss
+    shared_ptr<const V> get(const string& key, uint64_t generation) {
+        Shard& shard = shardFor(key);
+        lock_guard<mutex> lock(shard.lock);
+        if (shard.capacity == 0) return nullptr;
+        
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            shard.misses++;
+            return nullptr;
+        }
+        if (it->second->generation != generation) {
+            erase(shard, it->second);
+            shard.misses++;
+            return nullptr;
+        }
+        
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        shard.hits++;
+        return it->second->value;
+    }
+    
+    void put(string key, uint64_t generation, shared_ptr<const V> value) {
+        size_t bytes = sizeof(Entry) + key.size() + cacheBytes(*value);
+        Shard& shard = shardFor(key);
+        lock_guard<mutex> lock(shard.lock);
+        
+        // Another reader may have filled it since our miss
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) erase(shard, it->second);
+        if (bytes > shard.capacity) return;
+        
+        while (shard.bytes + bytes > shard.capacity) {
+            erase(shard, prev(shard.entries.end()));
+        }
+        shard.entries.push_front({move(key), generation, move(value), bytes});
+        shard.index[shard.entries.front().key] = shard.entries.begin();
+        shard.bytes += bytes;
+    }
+    
+    CacheStats stats() {
+        CacheStats total;
+        for (size_t i = 0; i < SHARDS; i++) {
+            lock_guard<mutex> lock(shards[i].lock);
+            total.capacity += shards[i].capacity;
+            total.hits += shards[i].hits;
+            total.misses += shards[i].misses;
+            total.entries += shards[i].entries.size();
+            total.bytes += shards[i].bytes;
+        }
+        return total;
+    }
+    
+private:
+    Shard& shardFor(const string& key) {
+        return shards[hash<string>()(key) % SHARDS];
+    }
+    
+    static void erase(Shard& shard, typename list<Entry>::iterator entry) {
+        shard.bytes -= entry->bytes;
+        shard.index.erase(entry->key);
+        shard.entries.erase(entry);
+    }
 };
 
 class MiniSearchEngine {
     Trie trie;
-    unordered_map<string, unordered_set<int>> invertedIndex;
+    TopKSuggestions topSuggestions;
+    TermDictionary dictionary;
+    vector<PostingList> invertedIndex; // indexed by term ID
     vector<string> documents;
+    vector<uint32_t> docLengths;       // tokens per document
+    uint64_t totalLength = 0;
+    
+    // Set while serving a read-only segment; trie, dictionary and suggestions
+    // then borrow their columns from the same mapping.
+    struct MappedIndex {
+        shared_ptr<MappedFile> file;
+        Column<segment::TermPostings> terms;
+        Column<uint8_t> postingData;
+        Column<uint8_t> postingFreqs;
+        Column<uint8_t> postingPositions;
+        Column<PostingBlock> postingBlocks;
+        Column<uint64_t> docOffsets;
+        Column<char> docData;
+        Column<uint32_t> docLengths;
+        uint64_t totalLength;
+    };
+    shared_ptr<const MappedIndex> mapped;
+    
+    // Bumped by every change to the index; cached results from an older
+    // generation are never returned.
+    uint64_t generation = 0;
+    mutable QueryCache<vector<int>> resultCache;
+    mutable QueryCache<vector<string>> suggestionCache;
     
 public:
+    static constexpr size_t DEFAULT_CACHE_CAPACITY = 4 << 20;
+    
+    // Byte budget of each query cache (0 disables caching)
+    explicit MiniSearchEngine(size_t cacheCapacity = DEFAULT_CACHE_CAPACITY)
+        : resultCache(cacheCapacity), suggestionCache(cacheCapacity) {}
+    
     void addDocument(const string& doc) {
+        if (isReadOnly()) return;
+        generation++;
         int docId = documents.size();
         documents.push_back(doc);
         
-        // Tokenize document
-        vector<string> words = tokenize(doc);
+        // Tokenize document; sorting (term ID, position) pairs groups each
+        // term's occurrences with their positions in order
+        static thread_local Tokenizer tokenizer;
+        static thread_local vector<pair<uint32_t, uint32_t>> occurrences;
+        static thread_local vector<uint32_t> positions;
+        occurrences.clear();
+        for (string_view word : tokenizer.tokenize(doc)) {
+            occurrences.push_back({postingsFor(word), (uint32_t)occurrences.size()});
+        }
+        sort(occurrences.begin(), occurrences.end());
+        
+        uint32_t length = occurrences.size();
+        docLengths.push_back(length);
+        totalLength += length;
         
-        for (const string& word : words) {
-            // Add to inverted index
-            invertedIndex[word].insert(docId);
+        for (size_t i = 0, j; i < occurrences.size(); i = j) {
+            uint32_t termId = occurrences[i].first;
+            positions.clear();
+            for (j = i; j < occurrences.size() && occurrences[j].first == termId; j++) {
+                positions.push_back(occurrences[j].second);
+            }
+            
+            // Add to inverted index (doc IDs are assigned in increasing order)
+            PostingList& postings = invertedIndex[termId];
             
-            // Add to trie for suggestions
-            trie.insert(word);
+            // Add to trie for suggestions, ranked by document frequency
+            if (postings.add(docId, positions.data(), positions.size(), length)) {
+                topSuggestions.update(trie, dictionary, termId, postings.size());
+            }
         }
     }
     
-    vector<int> search(const string& term) {
-        vector<int> result;
-        if (invertedIndex.find(term) != invertedIndex.end()) {
-            result.assign(invertedIndex[term].begin(), invertedIndex[term].end());
+    // Bulk ingestion of a range of documents (numThreads = 0 uses every core)
+    template<typename Iterator>
+    void addDocuments(Iterator first, Iterator last, int numThreads = 0) {
+        if (isReadOnly()) return;
+        int begin = documents.size();
+        documents.insert(documents.end(), first, last);
+        indexBatch(begin, documents.size(), numThreads);
+    }
+    
+    // Bulk ingestion of a stream with one document per line
+    void addDocuments(istream& in, size_t batchSize = 65536, int numThreads = 0) {
+        if (isReadOnly()) return;
+        string line;
+        while (true) {
+            size_t begin = documents.size();
+            while (documents.size() - begin < batchSize && getline(in, line)) {
+                documents.push_back(move(line));
+            }
+            if (documents.size() == begin) break;
+            indexBatch(begin, documents.size(), numThreads);
         }
-        return result;
     }
     
-    vector<int> searchMultiple(const vector<string>& terms) {
+    vector<int> search(const string& term) const {
+        return cached(resultCache, "s" + term, [&]() -> vector<int> {
+            uint32_t termId = dictionary.find(term);
+            if (termId == TermDictionary::NONE) return {};
+            return postings(termId).decode();
+        });
+    }
+    
+    // Conjunctive (AND) query. Terms are evaluated rarest first; each step
+    // gallops through the next list when it is much longer than the current
+    // candidate set, and otherwise decodes it and runs the SIMD merge.
+    vector<int> searchMultiple(const vector<string>& terms) const {
         if (terms.empty()) return {};
         
-        vector<int> result = search(terms[0]);
+        // The result does not depend on term order or repeats
+        vector<string> key(terms);
+        sort(key.begin(), key.end());
+        key.erase(unique(key.begin(), key.end()), key.end());
+        string cacheKey = "m";
+        for (const string& term : key) {
+            cacheKey += term;
+            cacheKey += '\0';
+        }
+        return cached(resultCache, move(cacheKey), [&] { return intersect(terms); });
+    }
+    
+    // Phrase query: documents where the terms occur as consecutive tokens, in order
+    vector<int> searchPhrase(const vector<string>& terms) const {
+        if (terms.empty()) return {};
+        string cacheKey = "q";
+        for (const string& term : terms) {
+            cacheKey += term;
+            cacheKey += '\0';
+        }
+        return cached(resultCache, move(cacheKey), [&] { return matchPositions(terms, true, 0); });
+    }
+    
+    // Proximity query: documents where every term occurs, in any order, within
+    // a span of at most maxDistance positions (1 = adjacent)
+    vector<int> searchNear(const vector<string>& terms, int maxDistance) const {
+        if (terms.empty() || maxDistance < 0) return {};
+        vector<string> key(terms);
+        sort(key.begin(), key.end());
+        key.erase(unique(key.begin(), key.end()), key.end());
+        string cacheKey = "n" + to_string(maxDistance) + ":";
+        for (const string& term : key) {
+            cacheKey += term;
+            cacheKey += '\0';
+        }
+        return cached(resultCache, move(cacheKey), [&] { return matchPositions(key, false, maxDistance); });
+    }
+    
+    // Indexed terms within maxDistance edits of term, closest first
+    vector<pair<string, int>> fuzzyTerms(const string& term, int maxDistance = 1) const {
+        return trie.fuzzySearch(term, maxDistance);
+    }
+    
+    // Typo-tolerant search: documents containing any term within maxDistance
+    // edits of term (1-2 keeps the trie walk interactive)
+    vector<int> searchFuzzy(const string& term, int maxDistance = 1) const {
+        return cached(resultCache, "f" + to_string(maxDistance) + ":" + term, [&] {
+            vector<int> result;
+            for (const auto& match : trie.fuzzySearch(term, maxDistance)) {
+                postings(dictionary.find(match.first)).decodeInto(queryBuffers().decoded);
+                result.insert(result.end(), queryBuffers().decoded.begin(), queryBuffers().decoded.end());
+            }
+            sort(result.begin(), result.end());
+            result.erase(unique(result.begin(), result.end()), result.end());
+            return result;
+        });
+    }
+    
+    // Ranked OR query: the k best documents by BM25, highest score first.
+    vector<pair<int, double>> searchRanked(const vector<string>& terms, int k) const {
+        CollectionStats stats = {documentCount(), totalDocumentLength(), {}};
+        for (const string& term : terms) {
+            stats.documentFrequency.push_back(documentFrequency(term));
+        }
+        return searchRanked(terms, k, stats);
+    }
+    
+    // Collection-wide statistics for BM25, so an index that holds only part of
+    // a collection (one segment) still produces globally comparable scores.
+    struct CollectionStats {
+        size_t documentCount;
+        uint64_t totalLength;
+        vector<size_t> documentFrequency; // parallel to the query terms
+    };
+    
+    // Uses block-max WAND: cursors stay sorted by doc ID, and a document (or a
+    // whole run of blocks) is only scored when the sum of its terms' upper
+    // bounds can beat the current k-th best score.
+    vector<pair<int, double>> searchRanked(const vector<string>& terms, int k,
+                                           const CollectionStats& stats) const {
+        vector<pair<uint32_t, size_t>> termIds; // (term ID, global document frequency)
+        for (size_t i = 0; i < terms.size(); i++) {
+            uint32_t termId = dictionary.find(terms[i]);
+            if (termId != TermDictionary::NONE) termIds.push_back({termId, stats.documentFrequency[i]});
+        }
+        sort(termIds.begin(), termIds.end());
+        termIds.erase(unique(termIds.begin(), termIds.end()), termIds.end());
+        if (termIds.empty() || k <= 0) return {};
+        
+        double avgLength = (double)stats.totalLength / stats.documentCount;
         
-        for (int i = 1; i < terms.size(); i++) {
-            vector<int> termResults = search(terms[i]);
-            result = intersect(result, termResults);
+        struct Cursor {
+            PostingView::Iterator it;
+            double idf;
+            double maxScore;
+        };
+        vector<Cursor> cursors;
+        cursors.reserve(termIds.size());
+        for (auto [termId, df] : termIds) {
+            PostingView list = postings(termId);
+            double idf = bm25::idf(stats.documentCount, df);
+            double maxScore = 0;
+            for (uint32_t b = 0; b < list.blockCount; b++) {
+                maxScore = max(maxScore, bm25::blockBound(idf, list.blocks[b], avgLength));
+            }
+            cursors.push_back({list.iterator(), idf, maxScore});
         }
         
+        vector<Cursor*> order;
+        for (Cursor& cursor : cursors) order.push_back(&cursor);
+        auto currentDoc = [](const Cursor* c) {
+            return c->it.valid() ? c->it.docId() : INT_MAX;
+        };
+        
+        // Min-heap of the best k (score, docId) pairs seen so far
+        priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> best;
+        auto threshold = [&]() {
+            return (int)best.size() < k ? 0.0 : best.top().first;
+        };
+        
+        while (true) {
+            sort(order.begin(), order.end(), [&](const Cursor* a, const Cursor* b) {
+                return currentDoc(a) < currentDoc(b);
+            });
+            
+            // Pivot: first cursor at which the summed list bounds beat the threshold
+            int n = order.size(), pivot = -1;
+            double upper = 0;
+            for (int i = 0; i < n && order[i]->it.valid(); i++) {
+                upper += order[i]->maxScore;
+                if (upper > threshold()) {
+                    pivot = i;
+                    break;
+                }
+            }
+            if (pivot < 0) break;
+            
+            int pivotDoc = order[pivot]->it.docId();
+            while (pivot + 1 < n && currentDoc(order[pivot + 1]) == pivotDoc) pivot++;
+            
+            double blockUpper = 0;
+            for (int i = 0; i <= pivot; i++) {
+                const PostingBlock* block = order[i]->it.peekBlock(pivotDoc);
+                if (block) blockUpper += bm25::blockBound(order[i]->idf, *block, avgLength);
+            }
+            
+            if (blockUpper > threshold()) {
+                if (order[0]->it.docId() == pivotDoc) {
+                    double score = 0;
+                    uint32_t length = documentLength(pivotDoc);
+                    for (int i = 0; i <= pivot; i++) {
+                        score += bm25::score(order[i]->idf, order[i]->it.freq(), length, avgLength);
+                        order[i]->it.next();
+                    }
+                    if ((int)best.size() < k) {
+                        best.push({score, pivotDoc});
+                    } else if (score > best.top().first) {
+                        best.pop();
+                        best.push({score, pivotDoc});
+                    }
+                } else {
+                    // Bring a lagging cursor up to the pivot before scoring it
+                    order[0]->it.advance(pivotDoc);
+                }
+            } else {
+                // Nothing up to the end of the current blocks can qualify: skip past them
+                int next = pivot + 1 < n ? currentDoc(order[pivot + 1]) : INT_MAX;
+                Cursor* skip = order[0];
+                for (int i = 0; i <= pivot; i++) {
+                    const PostingBlock* block = order[i]->it.peekBlock(pivotDoc);
+                    if (block && block->lastDocId < (uint32_t)INT_MAX) {
+                        next = min(next, (int)block->lastDocId + 1);
+                    }
+                    if (order[i]->maxScore > skip->maxScore) skip = order[i];
+                }
+                skip->it.advance(next);
+            }
+        }
+        
+        vector<pair<int, double>> result;
+        while (!best.empty()) {
+            result.push_back({best.top().second, best.top().first});
+            best.pop();
+        }
+        reverse(result.begin(), result.end());
         return result;
     }
     
-    vector<string> getSuggestions(const string& prefix) {
-        return trie.getSuggestions(prefix);
+    vector<string> getSuggestions(const string& prefix) const {
+        return cached(suggestionCache, "p" + prefix, [&] { return trie.getSuggestions(prefix); });
+    }
+    
+    // Up to k (<= TopKSuggestions::K) completions, most frequent first
+    vector<string> getTopSuggestions(const string& prefix, int k = TopKSuggestions::K) const {
+        return cached(suggestionCache, "t" + to_string(k) + ":" + prefix,
+                      [&] { return topSuggestions.top(trie, dictionary, prefix, k); });
     }
     
-    void printResults(const vector<int>& docIds) {
+    // Hit/miss counters for sizing the caches
+    CacheStats resultCacheStats() const { return resultCache.stats(); }
+    CacheStats suggestionCacheStats() const { return suggestionCache.stats(); }
+    
+    void setCacheCapacity(size_t bytes) {
+        resultCache.setCapacity(bytes);
+        suggestionCache.setCapacity(bytes);
+    }
+    
+    void printResults(const vector<int>& docIds) const {
         cout << "Search Results:\n";
         for (int docId : docIds) {
-            cout << "Document " << docId << ": " << documents[docId] << "\n";
+            cout << "Document " << docId << ": " << document(docId) << "\n";
+        }
+    }
+    
+    string_view document(int docId) const {
+        if (!mapped) return documents[docId];
+        const uint64_t* offsets = mapped->docOffsets.data();
+        return string_view(mapped->docData.data() + offsets[docId], offsets[docId + 1] - offsets[docId]);
+    }
+    
+    size_t documentCount() const {
+        return mapped ? mapped->docOffsets.size() - 1 : documents.size();
+    }
+    
+    size_t documentFrequency(const string& term) const {
+        uint32_t termId = dictionary.find(term);
+        return termId == TermDictionary::NONE ? 0 : postings(termId).size();
+    }
+    
+    // Number of tokens in a document
+    uint32_t documentLength(int docId) const {
+        return mapped ? mapped->docLengths[docId] : docLengths[docId];
+    }
+    
+    uint64_t totalDocumentLength() const {
+        return mapped ? mapped->totalLength : totalLength;
+    }
+    
+    // Concatenates indexes in order (each part's doc IDs follow the previous
+    // part's) by appending their posting lists directly, without re-tokenizing.
+    static MiniSearchEngine merge(const vector<const MiniSearchEngine*>& parts) {
+        MiniSearchEngine merged;
+        vector<uint32_t> touched, positions;
+        
+        for (const MiniSearchEngine* part : parts) {
+            int base = merged.documents.size();
+            for (size_t docId = 0; docId < part->documentCount(); docId++) {
+                uint32_t length = part->documentLength(docId);
+                merged.documents.emplace_back(part->document(docId));
+                merged.docLengths.push_back(length);
+                merged.totalLength += length;
+            }
+            
+            for (uint32_t termId = 0; termId < part->dictionary.size(); termId++) {
+                uint32_t mergedId = merged.postingsFor(part->dictionary.term(termId));
+                PostingList& postings = merged.invertedIndex[mergedId];
+                for (auto it = part->postings(termId).iterator(); it.valid(); it.next()) {
+                    int docId = base + it.docId();
+                    it.positions(positions);
+                    postings.add(docId, positions.data(), positions.size(), merged.docLengths[docId]);
+                }
+                touched.push_back(mergedId);
+            }
+        }
+        
+        sort(touched.begin(), touched.end());
+        touched.erase(unique(touched.begin(), touched.end()), touched.end());
+        for (uint32_t termId : touched) {
+            merged.topSuggestions.update(merged.trie, merged.dictionary, termId,
+                                         merged.invertedIndex[termId].size());
+        }
+        return merged;
+    }
+    
+    // Converts the suggestion trie to its succinct LOUDS form (several times
+    // smaller, slower per step) once the index is complete. Queries keep
+    // working; adding documents afterwards reports an error.
+    void freeze() {
+        if (trie.isFrozen()) return;
+        topSuggestions.remap(trie.freeze());
+        generation++;
+    }
+    
+    // Writes the whole index as a segment file that open() can map.
+    bool save(const string& path) const {
+        if (mapped) {
+            cout << "Error: engine is already serving a read-only segment" << endl;
+            return false;
+        }
+        if (trie.isFrozen()) {
+            cout << "Error: cannot save a frozen engine" << endl;
+            return false;
+        }
+        
+        segment::Writer writer(path);
+        writer.write(segment::TERM_POOL, dictionary.poolColumn().data(), dictionary.poolColumn().size());
+        writer.write(segment::TERM_OFFSETS, dictionary.offsetColumn().data(), dictionary.offsetColumn().size());
+        writer.write(segment::TERM_TABLE, dictionary.tableColumn().data(), dictionary.tableColumn().size());
+        
+        vector<segment::TermPostings> terms;
+        uint64_t dataOffset = 0, freqOffset = 0, posOffset = 0;
+        uint32_t firstBlock = 0;
+        for (const PostingList& list : invertedIndex) {
+            terms.push_back({dataOffset, freqOffset, posOffset, firstBlock, (uint32_t)list.size()});
+            dataOffset += list.bytes().size();
+            freqOffset += list.freqBytes().size();
+            posOffset += list.positionBytes().size();
+            firstBlock += list.skipBlocks().size();
+        }
+        writer.write(segment::POSTING_TERMS, terms.data(), terms.size());
+        writer.begin(segment::POSTING_DATA);
+        for (const PostingList& list : invertedIndex) {
+            writer.append(list.bytes().data(), list.bytes().size());
+        }
+        writer.begin(segment::POSTING_FREQS);
+        for (const PostingList& list : invertedIndex) {
+            writer.append(list.freqBytes().data(), list.freqBytes().size());
+        }
+        writer.begin(segment::POSTING_POSITIONS);
+        for (const PostingList& list : invertedIndex) {
+            writer.append(list.positionBytes().data(), list.positionBytes().size());
+        }
+        writer.begin(segment::POSTING_BLOCKS);
+        for (const PostingList& list : invertedIndex) {
+            writer.append(list.skipBlocks().data(), list.skipBlocks().size());
         }
+        
+        writer.write(segment::TRIE_NODES, trie.nodeData(), trie.size());
+        writer.write(segment::TRIE_SLOTS, trie.slotData(), trie.slotCount());
+        // Suggestion lists are allocated with the first word; pad an empty
+        // engine's so the file always has one list per trie node
+        const Column<TopKSuggestions::Entry>& lists = topSuggestions.entryColumn();
+        const Column<uint8_t>& listCounts = topSuggestions.countColumn();
+        size_t missing = trie.size() - listCounts.size();
+        vector<TopKSuggestions::Entry> noEntries(missing * TopKSuggestions::K);
+        vector<uint8_t> noCounts(missing, 0);
+        writer.write(segment::SUGGESTION_ENTRIES, lists.data(), lists.size());
+        writer.append(noEntries.data(), noEntries.size());
+        writer.write(segment::SUGGESTION_COUNTS, listCounts.data(), listCounts.size());
+        writer.append(noCounts.data(), noCounts.size());
+        
+        vector<uint64_t> docOffsets(1, 0);
+        for (const string& doc : documents) {
+            docOffsets.push_back(docOffsets.back() + doc.size());
+        }
+        writer.write(segment::DOC_OFFSETS, docOffsets.data(), docOffsets.size());
+        writer.begin(segment::DOC_DATA);
+        for (const string& doc : documents) {
+            writer.append(doc.data(), doc.size());
+        }
+        writer.write(segment::DOC_LENGTHS, docLengths.data(), docLengths.size());
+        
+        segment::Stats stats = {documents.size(), totalLength};
+        writer.write(segment::STATS, &stats, 1);
+        
+        if (!writer.finish()) {
+            cout << "Error: failed to write segment " << path << endl;
+            return false;
+        }
+        return true;
+    }
+    
+    // Maps a segment written by save() and serves all queries from it.
+    // The engine becomes read-only; nothing is copied or rebuilt.
+    bool open(const string& path) {
+        auto file = make_shared<MappedFile>();
+        if (!file->open(path)) {
+            cout << "Error: cannot map segment " << path << endl;
+            return false;
+        }
+        
+        segment::Header header;
+        if (file->size() < sizeof(header)) {
+            cout << "Error: " << path << " is not an index segment" << endl;
+            return false;
+        }
+        memcpy(&header, file->data(), sizeof(header));
+        if (memcmp(header.magic, segment::MAGIC, sizeof(segment::MAGIC)) != 0 ||
+            header.sectionCount != segment::SECTION_COUNT) {
+            cout << "Error: " << path << " is not an index segment" << endl;
+            return false;
+        }
+        if (header.version != segment::VERSION) {
+            cout << "Error: unsupported segment version " << header.version << endl;
+            return false;
+        }
+        
+        auto pool = segment::section<char>(*file, header, segment::TERM_POOL);
+        auto offsets = segment::section<uint32_t>(*file, header, segment::TERM_OFFSETS);
+        auto table = segment::section<uint32_t>(*file, header, segment::TERM_TABLE);
+        auto terms = segment::section<segment::TermPostings>(*file, header, segment::POSTING_TERMS);
+        auto postingData = segment::section<uint8_t>(*file, header, segment::POSTING_DATA);
+        auto postingFreqs = segment::section<uint8_t>(*file, header, segment::POSTING_FREQS);
+        auto postingPositions = segment::section<uint8_t>(*file, header, segment::POSTING_POSITIONS);
+        auto postingBlocks = segment::section<PostingBlock>(*file, header, segment::POSTING_BLOCKS);
+        auto nodes = segment::section<TrieNode>(*file, header, segment::TRIE_NODES);
+        auto slots = segment::section<uint32_t>(*file, header, segment::TRIE_SLOTS);
+        auto entries = segment::section<TopKSuggestions::Entry>(*file, header, segment::SUGGESTION_ENTRIES);
+        auto counts = segment::section<uint8_t>(*file, header, segment::SUGGESTION_COUNTS);
+        auto docOffsets = segment::section<uint64_t>(*file, header, segment::DOC_OFFSETS);
+        auto docData = segment::section<char>(*file, header, segment::DOC_DATA);
+        auto docLengths = segment::section<uint32_t>(*file, header, segment::DOC_LENGTHS);
+        auto stats = segment::section<segment::Stats>(*file, header, segment::STATS);
+        
+        if (!pool || !offsets || !table || !terms || !postingData || !postingFreqs ||
+            !postingPositions || !postingBlocks || !nodes || !slots || !entries ||
+            !counts || !docOffsets || !docData || !docLengths || !stats || stats->size() != 1) {
+            cout << "Error: segment " << path << " is corrupt" << endl;
+            return false;
+        }
+        
+        // Sections must agree with each other, so a truncated or damaged file
+        // is rejected here instead of reading out of bounds later, or probing
+        // forever in a term table with no empty slot. Besides O(1) size
+        // checks this is one pass over the term table and the term records.
+        size_t termCount = terms->size();
+        size_t documentCount = (*stats)[0].documentCount;
+        bool consistent =
+            offsets->size() == termCount + 1 && offsets->back() <= pool->size() &&
+            table->size() > termCount && (table->size() & (table->size() - 1)) == 0 &&
+            nodes->size() > 0 && counts->size() == nodes->size() &&
+            entries->size() == nodes->size() * TopKSuggestions::K &&
+            docOffsets->size() == documentCount + 1 && docOffsets->back() <= docData->size() &&
+            docLengths->size() == documentCount;
+        size_t usedSlots = 0;
+        for (size_t i = 0; consistent && i < table->size(); i++) {
+            uint32_t termId = (*table)[i];
+            if (termId != TermDictionary::NONE) {
+                consistent = termId < termCount;
+                usedSlots++;
+            }
+        }
+        consistent = consistent && usedSlots == termCount;
+        for (size_t i = 0; consistent && i < termCount; i++) {
+            const segment::TermPostings& term = (*terms)[i];
+            uint64_t blockCount = ((uint64_t)term.count + PostingView::BLOCK_SIZE - 1) / PostingView::BLOCK_SIZE;
+            consistent = term.dataOffset <= postingData->size() && term.freqOffset <= postingFreqs->size() &&
+                         term.posOffset <= postingPositions->size() && term.firstBlock <= postingBlocks->size() &&
+                         blockCount <= postingBlocks->size() - term.firstBlock;
+        }
+        if (!consistent) {
+            cout << "Error: segment " << path << " is corrupt" << endl;
+            return false;
+        }
+        
+        trie = Trie(nodes->data(), nodes->size(), slots->data());
+        dictionary = TermDictionary(*pool, *offsets, *table);
+        topSuggestions = TopKSuggestions(*entries, *counts);
+        invertedIndex.clear();
+        documents.clear();
+        this->docLengths.clear();
+        totalLength = 0;
+        generation++;
+        mapped = make_shared<MappedIndex>(MappedIndex{file, *terms, *postingData, *postingFreqs,
+                                                      *postingPositions, *postingBlocks, *docOffsets,
+                                                      *docData, *docLengths, (*stats)[0].totalLength});
+        return true;
     }
     
 private:
-    vector<string> tokenize(const string& doc) {
-        vector<string> words;
-        string word;
+    bool isReadOnly() const {
+        if (mapped) cout << "Error: cannot add documents to a read-only segment" << endl;
+        else if (trie.isFrozen()) cout << "Error: cannot add documents to a frozen engine" << endl;
+        return mapped != nullptr || trie.isFrozen();
+    }
+    
+    PostingView postings(uint32_t termId) const {
+        if (!mapped) return invertedIndex[termId].view();
+        
+        const segment::TermPostings& term = mapped->terms[termId];
+        uint32_t blockCount = (term.count + PostingView::BLOCK_SIZE - 1) / PostingView::BLOCK_SIZE;
+        return {mapped->postingData.data() + term.dataOffset,
+                mapped->postingFreqs.data() + term.freqOffset,
+                mapped->postingPositions.data() + term.posOffset,
+                mapped->postingBlocks.data() + term.firstBlock, blockCount, term.count};
+    }
+    
+    // Term ID for a word, growing the index when the word is new
+    uint32_t postingsFor(string_view word) {
+        uint32_t termId = dictionary.intern(word);
+        if (termId == invertedIndex.size()) invertedIndex.emplace_back();
+        return termId;
+    }
+    
+    // Fewest documents worth an indexing thread (see threadsFor)
+    static constexpr int MIN_DOCS_PER_THREAD = 256;
+    
+    struct Posting {
+        int docId;
+        uint32_t freq;
+    };
+    
+    // Sorted postings per (thread-local) term ID for one thread's slice of a
+    // batch, with each term's positions concatenated in posting order
+    struct PartialIndex {
+        TermDictionary terms;
+        vector<vector<Posting>> postings;
+        vector<vector<uint32_t>> positions;
+    };
+    
+    // Indexes documents[begin, end) in three phases:
+    //  1. each thread tokenizes a contiguous doc ID slice into a partial index
+    //     with its own local term dictionary;
+    //  2. local terms are interned globally and every term's slices are routed,
+    //     in slice order, to one merge shard;
+    //  3. shards append to their posting lists in parallel, which keeps doc IDs
+    //     sorted because slices are visited in order.
+    // The trie is then updated once per distinct term with its final frequency.
+    void indexBatch(int begin, int end, int numThreads) {
+        int n = end - begin;
+        if (n <= 0) return;
+        generation++;
+        numThreads = threadsFor(numThreads, n, MIN_DOCS_PER_THREAD);
         
-        for (char c : doc) {
-            if (isalpha(c)) {
-                word += tolower(c);
-            } else if (!word.empty()) {
-                words.push_back(word);
-                word.clear();
+        docLengths.resize(end);
+        vector<PartialIndex> partials(numThreads);
+        parallelFor(numThreads, [&](int t) {
+            int lo = begin + (long long)n * t / numThreads;
+            int hi = begin + (long long)n * (t + 1) / numThreads;
+            PartialIndex& partial = partials[t];
+            Tokenizer tokenizer;
+            
+            for (int docId = lo; docId < hi; docId++) {
+                const vector<string_view>& words = tokenizer.tokenize(documents[docId]);
+                docLengths[docId] = words.size();
+                
+                for (uint32_t position = 0; position < words.size(); position++) {
+                    uint32_t localId = partial.terms.intern(words[position]);
+                    if (localId == partial.postings.size()) {
+                        partial.postings.emplace_back();
+                        partial.positions.emplace_back();
+                    }
+                    
+                    vector<Posting>& postings = partial.postings[localId];
+                    if (postings.empty() || postings.back().docId != docId) {
+                        postings.push_back({docId, 1});
+                    } else {
+                        postings.back().freq++;
+                    }
+                    partial.positions[localId].push_back(position);
+                }
             }
+        });
+        for (int docId = begin; docId < end; docId++) {
+            totalLength += docLengths[docId];
         }
         
-        if (!word.empty()) {
-            words.push_back(word);
+        struct Slice {
+            uint32_t termId;
+            const vector<Posting>* postings;
+            const uint32_t* positions;
+        };
+        vector<vector<Slice>> shards(numThreads);
+        vector<uint32_t> touched;
+        
+        for (const PartialIndex& partial : partials) {
+            for (uint32_t localId = 0; localId < partial.postings.size(); localId++) {
+                uint32_t termId = postingsFor(partial.terms.term(localId));
+                shards[termId % numThreads].push_back({termId, &partial.postings[localId],
+                                                       partial.positions[localId].data()});
+                touched.push_back(termId);
+            }
         }
         
-        return words;
+        parallelFor(numThreads, [&](int t) {
+            for (const Slice& slice : shards[t]) {
+                PostingList& postings = invertedIndex[slice.termId];
+                const uint32_t* positions = slice.positions;
+                for (const Posting& posting : *slice.postings) {
+                    postings.add(posting.docId, positions, posting.freq, docLengths[posting.docId]);
+                    positions += posting.freq;
+                }
+            }
+        });
+        
+        sort(touched.begin(), touched.end());
+        touched.erase(unique(touched.begin(), touched.end()), touched.end());
+        for (uint32_t termId : touched) {
+            topSuggestions.update(trie, dictionary, termId, invertedIndex[termId].size());
+        }
     }
     
-    vector<int> intersect(const vector<int>& a, const vector<int>& b) {
-        vector<int> result;
-        int i = 0, j = 0;
+    // Returns the cached value for key at the current generation, computing
+    // and storing it on a miss.
+    template<typename V, typename Compute>
+    V cached(QueryCache<V>& cache, string key, Compute compute) const {
+        if (shared_ptr<const V> hit = cache.get(key, generation)) return *hit;
+        auto result = make_shared<const V>(compute());
+        cache.put(move(key), generation, result);
+        return *result;
+    }
+    
+    vector<int> intersect(const vector<string>& terms) const {
+        vector<PostingView> lists;
+        for (const string& term : terms) {
+            uint32_t termId = dictionary.find(term);
+            if (termId == TermDictionary::NONE) return {};
+            lists.push_back(postings(termId));
+        }
         
-        while (i < a.size() && j < b.size()) {
-            if (a[i] == b[j]) {
-                result.push_back(a[i]);
-                i++;
-                j++;
-            } else if (a[i] < b[j]) {
-                i++;
+        sort(lists.begin(), lists.end(), [](const PostingView& a, const PostingView& b) {
+            return a.size() < b.size();
+        });
+        
+        QueryBuffers& buf = queryBuffers();
+        lists[0].decodeInto(buf.candidates);
+        
+        for (size_t i = 1; i < lists.size() && !buf.candidates.empty(); i++) {
+            const PostingView& list = lists[i];
+            
+            if (list.size() >= GALLOP_RATIO * buf.candidates.size()) {
+                intersection::galloping(buf.candidates, list, buf.output);
             } else {
-                j++;
+                list.decodeInto(buf.decoded);
+                buf.output.resize(min(buf.candidates.size(), buf.decoded.size()));
+                size_t n = intersection::simd(buf.candidates.data(), buf.candidates.size(),
+                                              buf.decoded.data(), buf.decoded.size(),
+                                              buf.output.data());
+                buf.output.resize(n);
             }
+            
+            swap(buf.candidates, buf.output);
         }
         
+        return buf.candidates;
+    }
+    
+    // Doc-at-a-time intersection, rarest list leading, that checks positions
+    // as soon as every iterator sits on the same document; positions of the
+    // other documents are never decoded.
+    vector<int> matchPositions(const vector<string>& terms, bool phrase, int maxDistance) const {
+        struct Cursor {
+            PostingView::Iterator it;
+            uint32_t offset; // position of the term within the phrase
+            size_t size;
+        };
+        vector<Cursor> cursors;
+        for (size_t i = 0; i < terms.size(); i++) {
+            uint32_t termId = dictionary.find(terms[i]);
+            if (termId == TermDictionary::NONE) return {};
+            PostingView list = postings(termId);
+            cursors.push_back({list.iterator(), (uint32_t)i, list.size()});
+        }
+        sort(cursors.begin(), cursors.end(), [](const Cursor& a, const Cursor& b) {
+            return a.size < b.size;
+        });
+        
+        vector<vector<uint32_t>>& positions = queryBuffers().positions;
+        positions.resize(cursors.size());
+        
+        vector<int> result;
+        PostingView::Iterator& lead = cursors[0].it;
+        while (lead.valid()) {
+            int docId = lead.docId();
+            bool aligned = true;
+            for (size_t i = 1; i < cursors.size(); i++) {
+                PostingView::Iterator& it = cursors[i].it;
+                it.advance(docId);
+                if (!it.valid()) return result;
+                if (it.docId() != docId) {
+                    lead.advance(it.docId());
+                    aligned = false;
+                    break;
+                }
+            }
+            if (!aligned) continue;
+            
+            for (size_t i = 0; i < cursors.size(); i++) {
+                cursors[i].it.positions(positions[i]);
+            }
+            bool match = phrase ? phraseMatch(cursors, positions) : withinSpan(positions, maxDistance);
+            if (match) result.push_back(docId);
+            lead.next();
+        }
         return result;
     }
+    
+    // Is there a start s with term i at s + offset_i for every term?
+    template<typename Cursors>
+    static bool phraseMatch(const Cursors& cursors, const vector<vector<uint32_t>>& positions) {
+        vector<size_t> next(cursors.size(), 0);
+        for (uint32_t p : positions[0]) {
+            if (p < cursors[0].offset) continue;
+            uint32_t start = p - cursors[0].offset;
+            
+            bool found = true;
+            for (size_t i = 1; i < cursors.size() && found; i++) {
+                const vector<uint32_t>& list = positions[i];
+                uint32_t target = start + cursors[i].offset;
+                while (next[i] < list.size() && list[next[i]] < target) next[i]++;
+                if (next[i] == list.size()) return false;
+                found = list[next[i]] == target;
+            }
+            if (found) return true;
+        }
+        return false;
+    }
+    
+    // Smallest window holding one position from every list, found by
+    // repeatedly advancing the list with the smallest current position.
+    static bool withinSpan(const vector<vector<uint32_t>>& positions, int maxDistance) {
+        vector<size_t> next(positions.size(), 0);
+        while (true) {
+            size_t lowest = 0;
+            uint32_t lo = UINT32_MAX, hi = 0;
+            for (size_t i = 0; i < positions.size(); i++) {
+                uint32_t p = positions[i][next[i]];
+                if (p < lo) {
+                    lo = p;
+                    lowest = i;
+                }
+                hi = max(hi, p);
+            }
+            if (hi - lo <= (uint32_t)maxDistance) return true;
+            if (++next[lowest] == positions[lowest].size()) return false;
+        }
+    }
+    
+    // Size ratio above which probing beats a linear merge.
+    static constexpr size_t GALLOP_RATIO = 32;
+    
+    // Scratch space reused by every query on the calling thread.
+    struct QueryBuffers {
+        vector<int> candidates, decoded, output;
+        vector<vector<uint32_t>> positions;
+    };
+    
+    static QueryBuffers& queryBuffers() {
+        static thread_local QueryBuffers buffers;
+        return buffers;
+    }
+};
+
+// Concurrent Search Engine
+// Near-real-time indexing where queries never wait for writers. New
+// documents go into an in-memory write buffer; flush() seals the buffer into
+// an immutable segment (freezing its trie) and publishes a new snapshot (the
+// segment list) with an atomic shared_ptr store. Readers atomically load the
+// current snapshot and query its segments without taking the engine's writer
+// lock, so ingestion and merges never stall them, and old segments are freed
+// once the last snapshot referencing them is dropped. Reads are not lock-free:
+// the library may guard shared_ptr atomics with an internal lock, and the
+// query caches lock one shard per lookup, but both are held only briefly.
+// A background thread keeps the segment count bounded by merging the
+// smallest adjacent pair at the posting-list level.
+class ConcurrentSearchEngine {
+    struct Segment {
+        shared_ptr<const MiniSearchEngine> index;
+        int docBase;
+    };
+    
+    struct Snapshot {
+        vector<Segment> segments;
+        int documentCount = 0;
+    };
+    
+    shared_ptr<const Snapshot> snapshot; // only accessed through atomic_load/atomic_store
+    mutex writeMutex;                    // serializes writers and snapshot publishers
+    MiniSearchEngine buffer;
+    size_t flushThreshold;
+    size_t maxSegments;
+    
+    thread merger;
+    mutex mergeMutex;
+    condition_variable mergeSignal;
+    bool mergeRequested = false;
+    bool stopping = false;
+    
+public:
+    explicit ConcurrentSearchEngine(size_t flushThreshold = 10000, size_t maxSegments = 8)
+        : snapshot(make_shared<const Snapshot>()), flushThreshold(flushThreshold),
+          maxSegments(max<size_t>(1, maxSegments)) {
+        merger = thread([this] { mergeLoop(); });
+    }
+    
+    ~ConcurrentSearchEngine() {
+        {
+            lock_guard<mutex> lock(mergeMutex);
+            stopping = true;
+        }
+        mergeSignal.notify_one();
+        merger.join();
+    }
+    
+    // Buffered; searchable after the next flush (automatic every flushThreshold documents)
+    void addDocument(const string& doc) {
+        lock_guard<mutex> lock(writeMutex);
+        buffer.addDocument(doc);
+        if (buffer.documentCount() >= flushThreshold) flushLocked();
+    }
+    
+    template<typename Iterator>
+    void addDocuments(Iterator first, Iterator last, int numThreads = 0) {
+        lock_guard<mutex> lock(writeMutex);
+        buffer.addDocuments(first, last, numThreads);
+        if (buffer.documentCount() >= flushThreshold) flushLocked();
+    }
+    
+    // Makes every buffered document visible to readers
+    void flush() {
+        lock_guard<mutex> lock(writeMutex);
+        flushLocked();
+    }
+    
+    vector<int> search(const string& term) const {
+        return collect([&](const MiniSearchEngine& index) { return index.search(term); });
+    }
+    
+    vector<int> searchMultiple(const vector<string>& terms) const {
+        return collect([&](const MiniSearchEngine& index) { return index.searchMultiple(terms); });
+    }
+    
+    vector<int> searchPhrase(const vector<string>& terms) const {
+        return collect([&](const MiniSearchEngine& index) { return index.searchPhrase(terms); });
+    }
+    
+    vector<int> searchNear(const vector<string>& terms, int maxDistance) const {
+        return collect([&](const MiniSearchEngine& index) { return index.searchNear(terms, maxDistance); });
+    }
+    
+    vector<int> searchFuzzy(const string& term, int maxDistance = 1) const {
+        return collect([&](const MiniSearchEngine& index) { return index.searchFuzzy(term, maxDistance); });
+    }
+    
+    // BM25 with collection-wide statistics, so scores are comparable across segments
+    vector<pair<int, double>> searchRanked(const vector<string>& terms, int k) const {
+        auto snap = current();
+        if (snap->documentCount == 0) return {};
+        
+        MiniSearchEngine::CollectionStats stats = {(size_t)snap->documentCount, 0,
+                                                   vector<size_t>(terms.size(), 0)};
+        for (const Segment& segment : snap->segments) {
+            stats.totalLength += segment.index->totalDocumentLength();
+            for (size_t i = 0; i < terms.size(); i++) {
+                stats.documentFrequency[i] += segment.index->documentFrequency(terms[i]);
+            }
+        }
+        
+        vector<pair<int, double>> result;
+        for (const Segment& segment : snap->segments) {
+            for (auto [docId, score] : segment.index->searchRanked(terms, k, stats)) {
+                result.push_back({segment.docBase + docId, score});
+            }
+        }
+        // Same order as the per-segment heap: score, then doc ID, both descending
+        sort(result.begin(), result.end(), [](const pair<int, double>& a, const pair<int, double>& b) {
+            return a.second != b.second ? a.second > b.second : a.first > b.first;
+        });
+        if ((int)result.size() > k) result.resize(max(k, 0));
+        return result;
+    }
+    
+    vector<string> getSuggestions(const string& prefix) const {
+        auto snap = current();
+        vector<string> result;
+        for (const Segment& segment : snap->segments) {
+            vector<string> words = segment.index->getSuggestions(prefix);
+            result.insert(result.end(), words.begin(), words.end());
+        }
+        sort(result.begin(), result.end());
+        result.erase(unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+    
+    // Candidates are each segment's top-K; they are re-ranked by their summed
+    // document frequency, which is exact once segments have been merged.
+    vector<string> getTopSuggestions(const string& prefix, int k = TopKSuggestions::K) const {
+        auto snap = current();
+        vector<string> candidates;
+        for (const Segment& segment : snap->segments) {
+            vector<string> words = segment.index->getTopSuggestions(prefix);
+            candidates.insert(candidates.end(), words.begin(), words.end());
+        }
+        sort(candidates.begin(), candidates.end());
+        candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+        
+        vector<pair<size_t, string>> ranked;
+        for (string& word : candidates) {
+            size_t df = 0;
+            for (const Segment& segment : snap->segments) {
+                df += segment.index->documentFrequency(word);
+            }
+            ranked.push_back({df, move(word)});
+        }
+        sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        
+        vector<string> result;
+        for (int i = 0; i < min<int>(k, ranked.size()); i++) {
+            result.push_back(move(ranked[i].second));
+        }
+        return result;
+    }
+    
+    // Copied out: the segment holding it may be merged away after we return
+    string document(int docId) const {
+        auto snap = current();
+        auto it = upper_bound(snap->segments.begin(), snap->segments.end(), docId,
+                              [](int id, const Segment& segment) { return id < segment.docBase; });
+        const Segment& segment = *prev(it);
+        return string(segment.index->document(docId - segment.docBase));
+    }
+    
+    size_t documentCount() const { return current()->documentCount; }
+    size_t segmentCount() const { return current()->segments.size(); }
+    
+    void printResults(const vector<int>& docIds) const {
+        cout << "Search Results:\n";
+        for (int docId : docIds) {
+            cout << "Document " << docId << ": " << document(docId) << "\n";
+        }
+    }
+    
+private:
+    shared_ptr<const Snapshot> current() const {
+        return atomic_load(&snapshot);
+    }
+    
+    // Runs a doc ID query on every segment of one snapshot, in doc ID order
+    template<typename Query>
+    vector<int> collect(Query query) const {
+        auto snap = current();
+        vector<int> result;
+        for (const Segment& segment : snap->segments) {
+            for (int docId : query(*segment.index)) {
+                result.push_back(segment.docBase + docId);
+            }
+        }
+        return result;
+    }
+    
+    // Caller holds writeMutex
+    void flushLocked() {
+        if (buffer.documentCount() == 0) return;
+        
+        buffer.freeze();
+        auto sealed = make_shared<const MiniSearchEngine>(move(buffer));
+        buffer = MiniSearchEngine();
+        
+        auto old = current();
+        auto next = make_shared<Snapshot>(*old);
+        next->segments.push_back({sealed, old->documentCount});
+        next->documentCount += sealed->documentCount();
+        atomic_store(&snapshot, shared_ptr<const Snapshot>(next));
+        
+        if (next->segments.size() > maxSegments) {
+            {
+                lock_guard<mutex> lock(mergeMutex);
+                mergeRequested = true;
+            }
+            mergeSignal.notify_one();
+        }
+    }
+    
+    void mergeLoop() {
+        while (true) {
+            {
+                unique_lock<mutex> lock(mergeMutex);
+                mergeSignal.wait(lock, [this] { return stopping || mergeRequested; });
+                if (stopping) return;
+                mergeRequested = false;
+            }
+            
+            while (true) {
+                auto snap = current();
+                const vector<Segment>& segments = snap->segments;
+                if (segments.size() <= maxSegments) break;
+                
+                // Smallest adjacent pair; adjacency keeps every segment's doc IDs contiguous
+                size_t best = 0, bestSize = SIZE_MAX;
+                for (size_t i = 0; i + 1 < segments.size(); i++) {
+                    size_t size = segments[i].index->documentCount() + segments[i + 1].index->documentCount();
+                    if (size < bestSize) {
+                        best = i;
+                        bestSize = size;
+                    }
+                }
+                
+                MiniSearchEngine merged = MiniSearchEngine::merge(
+                    {segments[best].index.get(), segments[best + 1].index.get()});
+                merged.freeze();
+                auto sealed = make_shared<const MiniSearchEngine>(move(merged));
+                
+                // Only this thread removes segments and flushes only append,
+                // so the pair is still at the same position in the latest snapshot.
+                lock_guard<mutex> lock(writeMutex);
+                auto latest = current();
+                auto next = make_shared<Snapshot>(*latest);
+                next->segments[best] = {sealed, latest->segments[best].docBase};
+                next->segments.erase(next->segments.begin() + best + 1);
+                atomic_store(&snapshot, shared_ptr<const Snapshot>(next));
+                
+                lock_guard<mutex> stopLock(mergeMutex);
+                if (stopping) return;
+            }
+        }
+    }
 };
 
 // Demo function
@@ -186,6 +1997,15 @@ void demonstrateSearchEngine() {
     engine.printResults(multiResults);
     cout << "\n";
     
+    // Phrase and proximity search
+    cout << "Searching for the phrase 'lazy dog':\n";
+    engine.printResults(engine.searchPhrase({"lazy", "dog"}));
+    cout << "\n";
+    
+    cout << "Searching for 'fox' within 4 words of 'lazy':\n";
+    engine.printResults(engine.searchNear({"fox", "lazy"}, 4));
+    cout << "\n";
+    
     // Prefix suggestions
     cout << "Suggestions for 'qu':\n";
     auto suggestions = engine.getSuggestions("qu");
@@ -194,10 +2014,39 @@ void demonstrateSearchEngine() {
     }
     cout << "\n";
     
+    // Ranked completions
+    cout << "Top 3 suggestions for 'f':\n";
+    for (const string& suggestion : engine.getTopSuggestions("f", 3)) {
+        cout << "- " << suggestion << "\n";
+    }
+    cout << "\n";
+    
+    // Ranked OR search
+    cout << "Top 3 ranked results for 'lazy fox':\n";
+    for (auto [docId, score] : engine.searchRanked({"lazy", "fox"}, 3)) {
+        cout << "Document " << docId << " (" << fixed << setprecision(3) << score << "): "
+             << engine.document(docId) << "\n";
+    }
+    cout << "\n";
+    
+    // Typo-tolerant search
+    cout << "Terms within 1 edit of 'foxs':\n";
+    for (const auto& [term, distance] : engine.fuzzyTerms("foxs", 1)) {
+        cout << "- " << term << " (" << distance << ")\n";
+    }
+    cout << "\n";
+    
     // Another search
     cout << "Searching for 'lazy':\n";
     auto lazyResults = engine.search("lazy");
     engine.printResults(lazyResults);
+    cout << "\n";
+    
+    // Repeated queries are answered from the cache until the index changes
+    engine.search("fox");
+    engine.searchMultiple({"dog", "fox"});
+    CacheStats cache = engine.resultCacheStats();
+    cout << "Result cache: " << cache.hits << " hits, " << cache.misses << " misses\n";
 }
 
 int main() {
@@ -213,17 +2062,41 @@ Searching for 'fox':
 Search Results:
 Document 0: The quick brown fox jumps over the lazy dog
 Document 1: A quick brown fox runs in the forest
-Document 3: Foxes are beautiful animals
 
 Searching for 'fox' AND 'dog':
 Search Results:
 Document 0: The quick brown fox jumps over the lazy dog
 
+Searching for the phrase 'lazy dog':
+Search Results:
+Document 0: The quick brown fox jumps over the lazy dog
+Document 2: The lazy dog sleeps all day
+
+Searching for 'fox' within 4 words of 'lazy':
+Search Results:
+Document 0: The quick brown fox jumps over the lazy dog
+
 Suggestions for 'qu':
 - quick
 
+Top 3 suggestions for 'f':
+- fox
+- forest
+- foxes
+
+Top 3 ranked results for 'lazy fox':
+Document 0 (1.478): The quick brown fox jumps over the lazy dog
+Document 2 (0.887): The lazy dog sleeps all day
+Document 1 (0.783): A quick brown fox runs in the forest
+
+Terms within 1 edit of 'foxs':
+- fox (1)
+- foxes (1)
+
 Searching for 'lazy':
 Search Results:
 Document 0: The quick brown fox jumps over the lazy dog
 Document 2: The lazy dog sleeps all day
+
+Result cache: 2 hits, 5 misses
 */
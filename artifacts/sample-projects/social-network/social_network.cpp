@@ -32,38 +32,1386 @@ struct User {
     }
 };
 
+// Interned strings with dense IDs in first-seen order
+class StringDictionary {
+    deque<string> names;                     // stable addresses for the keys below
+    unordered_map<string_view, uint32_t> ids;
+    
+public:
+    uint32_t intern(string_view text) {
+        auto it = ids.find(text);
+        if (it != ids.end()) return it->second;
+        uint32_t id = names.size();
+        names.emplace_back(text);
+        ids.emplace(names.back(), id);
+        return id;
+    }
+    
+    // -1 if the string was never interned
+    int find(string_view text) const {
+        auto it = ids.find(text);
+        return it == ids.end() ? -1 : (int)it->second;
+    }
+    
+    const string& name(uint32_t id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+};
+
+// Struct-of-arrays user storage
+// Each attribute is one column indexed by row, with rows in insertion order.
+// Names share one character pool. Locations are interned into 32-bit IDs,
+// and interests into a dictionary whose IDs index a fixed-width bitset per
+// user. A user costs its columns, one ID index entry, the name characters
+// and one bit per known interest, with no per-user heap allocations. Filters
+// scan one column at a time and return bitmaps over rows, which AND together
+// word by word.
+class UserStore {
+public:
+    using Mask = vector<uint64_t>;
+    
+private:
+    vector<int> ids;                   // row -> user ID
+    unordered_map<int, uint32_t> rows; // user ID -> row
+    string namePool;
+    vector<uint32_t> nameStart, nameLength;
+    vector<int> ages;
+    vector<int> joinDates;
+    vector<uint32_t> locationIds;
+    vector<uint64_t> interestBits;     // interestWords words per row
+    int interestWords = 1;
+    StringDictionary locations, interests;
+    
+    // Widens every row's bitset once the dictionary outgrows it
+    void reserveInterest(uint32_t interestId) {
+        if (interestId < (uint32_t)interestWords * 64) return;
+        int words = interestWords;
+        while (interestId >= (uint32_t)words * 64) words *= 2;
+        vector<uint64_t> widened(ids.size() * words, 0);
+        for (size_t row = 0; row < ids.size(); row++) {
+            copy_n(interestBits.begin() + row * interestWords, interestWords, widened.begin() + row * words);
+        }
+        interestBits.swap(widened);
+        interestWords = words;
+    }
+    
+    // Packs pred(row) for every row into a bitmap, 64 rows per word
+    template<typename F>
+    Mask scan(F pred) const {
+        size_t n = ids.size();
+        Mask mask((n + 63) / 64, 0);
+        for (size_t base = 0; base < n; base += 64) {
+            size_t count = min<size_t>(64, n - base);
+            uint64_t word = 0;
+            for (size_t j = 0; j < count; j++) word |= (uint64_t)pred(base + j) << j;
+            mask[base / 64] = word;
+        }
+        return mask;
+    }
+    
+public:
+    // Inserts or replaces a user. Replacing leaves the old name bytes
+    // unreferenced in the pool.
+    void put(const User& user) {
+        auto [it, inserted] = rows.try_emplace(user.id, ids.size());
+        uint32_t row = it->second;
+        if (inserted) {
+            ids.push_back(user.id);
+            nameStart.push_back(0);
+            nameLength.push_back(0);
+            ages.push_back(0);
+            joinDates.push_back(0);
+            locationIds.push_back(0);
+            interestBits.resize(interestBits.size() + interestWords, 0);
+        }
+        
+        nameStart[row] = namePool.size();
+        nameLength[row] = user.name.size();
+        namePool += user.name;
+        ages[row] = user.age;
+        joinDates[row] = user.joinDate;
+        locationIds[row] = locations.intern(user.location);
+        
+        vector<uint32_t> interestIds;
+        for (const string& interest : user.interests) {
+            interestIds.push_back(interests.intern(interest));
+            reserveInterest(interestIds.back());
+        }
+        fill_n(interestBits.begin() + (size_t)row * interestWords, interestWords, 0);
+        for (uint32_t id : interestIds) {
+            interestBits[(size_t)row * interestWords + id / 64] |= 1ULL << (id % 64);
+        }
+    }
+    
+    bool has(int userId) const { return rows.count(userId) > 0; }
+    size_t size() const { return ids.size(); }
+    // User IDs in row order
+    const vector<int>& userIds() const { return ids; }
+    bool empty() const { return ids.empty(); }
+    
+    string_view name(int userId) const {
+        uint32_t row = rows.at(userId);
+        return string_view(namePool).substr(nameStart[row], nameLength[row]);
+    }
+    
+    // Interest IDs of a user, in dictionary order
+    vector<uint32_t> interestIds(int userId) const {
+        vector<uint32_t> result;
+        const uint64_t* bits = interestBits.data() + (size_t)rows.at(userId) * interestWords;
+        for (int w = 0; w < interestWords; w++) {
+            for (uint64_t word = bits[w]; word; word &= word - 1) {
+                result.push_back(w * 64 + __builtin_ctzll(word));
+            }
+        }
+        return result;
+    }
+    
+    const StringDictionary& interestDictionary() const { return interests; }
+    
+    // Rebuilds the row-oriented view of one user
+    User get(int userId) const {
+        uint32_t row = rows.at(userId);
+        User user(userId, string(name(userId)), ages[row], locations.name(locationIds[row]));
+        user.joinDate = joinDates[row];
+        for (uint32_t id : interestIds(userId)) user.addInterest(interests.name(id));
+        return user;
+    }
+    
+    // Filters
+    
+    Mask withLocation(const string& location) const {
+        int id = locations.find(location);
+        if (id < 0) return Mask((ids.size() + 63) / 64, 0);
+        return scan([&](size_t row) { return locationIds[row] == (uint32_t)id; });
+    }
+    
+    Mask withInterest(const string& interest) const {
+        int id = interests.find(interest);
+        if (id < 0) return Mask((ids.size() + 63) / 64, 0);
+        size_t word = id / 64;
+        int bit = id % 64;
+        return scan([&](size_t row) {
+            return interestBits[row * interestWords + word] >> bit & 1;
+        });
+    }
+    
+    Mask withAge(int minAge, int maxAge) const {
+        return scan([&](size_t row) { return ages[row] >= minAge && ages[row] <= maxAge; });
+    }
+    
+    static Mask both(Mask a, const Mask& b) {
+        for (size_t w = 0; w < a.size(); w++) a[w] &= b[w];
+        return a;
+    }
+    
+    // User IDs of the set rows, ascending
+    vector<int> usersIn(const Mask& mask) const {
+        vector<int> result;
+        for (size_t w = 0; w < mask.size(); w++) {
+            for (uint64_t word = mask[w]; word; word &= word - 1) {
+                result.push_back(ids[w * 64 + __builtin_ctzll(word)]);
+            }
+        }
+        sort(result.begin(), result.end());
+        return result;
+    }
+};
+
+// MinHash signatures with an LSH banding index over user interests
+// Entry i of a signature is the smallest value of hash function i over the
+// user's interest IDs, and two users agree on an entry with probability
+// equal to the Jaccard similarity of their interest sets. Signatures are cut
+// into BANDS bands of ROWS entries; users who agree on a whole band share a
+// bucket. A pair with similarity s collides in some band with probability
+// 1 - (1 - s^ROWS)^BANDS, so similar users are found by looking only at the
+// query's own buckets instead of comparing against every user. Users are
+// indexed one at a time as they are added, in O(interests * HASHES).
+class InterestIndex {
+public:
+    static constexpr int BANDS = 32;
+    static constexpr int ROWS = 2;  // collision probability crosses 1/2 near s = 0.15
+    static constexpr int HASHES = BANDS * ROWS;
+    // Bucket entries examined per band and query, so a bucket shared by a
+    // huge crowd with one common interest cannot make a query linear
+    static constexpr size_t MAX_BUCKET_SCAN = 256;
+    
+private:
+    vector<int> userIds;            // row -> user ID
+    unordered_map<int, uint32_t> rows;
+    vector<uint32_t> signatures;    // HASHES entries per row
+    vector<bool> indexed;           // row is in the buckets (has interests)
+    unordered_map<uint64_t, vector<uint32_t>> buckets[BANDS]; // band hash -> rows
+    vector<uint32_t> bucketSlots;   // BANDS per row: the row's index in each of its buckets
+    
+    static uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+    
+    uint64_t bandKey(uint32_t row, int band) const {
+        const uint32_t* sig = signatures.data() + (size_t)row * HASHES + band * ROWS;
+        uint64_t key = band;
+        for (int r = 0; r < ROWS; r++) key = mix(key ^ sig[r]);
+        return key;
+    }
+    
+    // Removes a row from its buckets in O(BANDS): the last row of each
+    // bucket moves into its slot
+    void unlink(uint32_t row) {
+        for (int band = 0; band < BANDS; band++) {
+            auto it = buckets[band].find(bandKey(row, band));
+            vector<uint32_t>& bucket = it->second;
+            uint32_t slot = bucketSlots[(size_t)row * BANDS + band];
+            bucket[slot] = bucket.back();
+            bucketSlots[(size_t)bucket[slot] * BANDS + band] = slot;
+            bucket.pop_back();
+            if (bucket.empty()) buckets[band].erase(it);
+        }
+    }
+    
+public:
+    // Indexes or re-indexes one user. A user without interests is similar to
+    // no one and is left out of the buckets.
+    void put(int userId, const vector<uint32_t>& interestIds) {
+        auto [it, inserted] = rows.try_emplace(userId, userIds.size());
+        uint32_t row = it->second;
+        if (inserted) {
+            userIds.push_back(userId);
+            signatures.resize(signatures.size() + HASHES);
+            bucketSlots.resize(bucketSlots.size() + BANDS);
+            indexed.push_back(false);
+        } else if (indexed[row]) {
+            unlink(row);
+        }
+        
+        indexed[row] = !interestIds.empty();
+        if (!indexed[row]) return;
+        uint32_t* sig = signatures.data() + (size_t)row * HASHES;
+        fill_n(sig, HASHES, UINT32_MAX);
+        for (int i = 0; i < HASHES; i++) {
+            for (uint32_t id : interestIds) {
+                sig[i] = min(sig[i], (uint32_t)(mix((uint64_t)i << 32 | id) >> 32));
+            }
+        }
+        for (int band = 0; band < BANDS; band++) {
+            vector<uint32_t>& bucket = buckets[band][bandKey(row, band)];
+            bucketSlots[(size_t)row * BANDS + band] = bucket.size();
+            bucket.push_back(row);
+        }
+    }
+    
+    size_t size() const { return userIds.size(); }
+    
+    // Users sharing at least one band with userId, paired with their estimated
+    // Jaccard similarity (the fraction of agreeing signature entries)
+    vector<pair<int, double>> candidates(int userId) const {
+        vector<pair<int, double>> result;
+        auto it = rows.find(userId);
+        if (it == rows.end() || !indexed[it->second]) return result;
+        uint32_t row = it->second;
+        const uint32_t* mine = signatures.data() + (size_t)row * HASHES;
+        
+        vector<uint32_t> found;
+        for (int band = 0; band < BANDS; band++) {
+            auto bucket = buckets[band].find(bandKey(row, band));
+            size_t scan = min(bucket->second.size(), MAX_BUCKET_SCAN);
+            for (size_t i = 0; i < scan; i++) {
+                if (bucket->second[i] != row) found.push_back(bucket->second[i]);
+            }
+        }
+        sort(found.begin(), found.end());
+        found.erase(unique(found.begin(), found.end()), found.end());
+        
+        for (uint32_t other : found) {
+            const uint32_t* theirs = signatures.data() + (size_t)other * HASHES;
+            int agree = 0;
+            for (int i = 0; i < HASHES; i++) agree += mine[i] == theirs[i];
+            result.push_back({userIds[other], (double)agree / HASHES});
+        }
+        return result;
+    }
+    
+    // Up to k most similar users (ties: higher user ID first)
+    vector<pair<int, double>> similarUsers(int userId, int k) const {
+        vector<pair<int, double>> result = candidates(userId);
+        auto better = [](const pair<int, double>& a, const pair<int, double>& b) {
+            return a.second != b.second ? a.second > b.second : a.first > b.first;
+        };
+        size_t top = min<size_t>(max(k, 0), result.size());
+        partial_sort(result.begin(), result.begin() + top, result.end(), better);
+        result.resize(top);
+        return result;
+    }
+};
+
+// Compressed sparse row (CSR) snapshot of the friendship graph
+// Users get dense vertex IDs 0..n-1 in user ID order, and the friends of
+// vertex v are neighbors[offsets[v] .. offsets[v + 1]), sorted and without
+// duplicates. Traversals walk one contiguous array and index plain vectors
+// instead of hashing user IDs; only the public API boundary translates.
+struct CSRGraph {
+    struct Range {
+        const int* first;
+        const int* last;
+        const int* begin() const { return first; }
+        const int* end() const { return last; }
+    };
+    
+    vector<size_t> offsets{0};
+    vector<int> neighbors;
+    vector<int> userIds;              // dense ID -> user ID
+    unordered_map<int, int> denseIds; // user ID -> dense ID
+    
+    static CSRGraph build(const unordered_map<int, vector<int>>& adjacencyList) {
+        CSRGraph graph;
+        graph.userIds.reserve(adjacencyList.size());
+        for (const auto& pair : adjacencyList) {
+            graph.userIds.push_back(pair.first);
+        }
+        sort(graph.userIds.begin(), graph.userIds.end());
+        
+        int n = graph.userIds.size();
+        graph.denseIds.reserve(n);
+        size_t total = 0;
+        for (int v = 0; v < n; v++) {
+            graph.denseIds[graph.userIds[v]] = v;
+            total += adjacencyList.at(graph.userIds[v]).size();
+        }
+        
+        // Rows are written back to back; dropping duplicates and self-loops
+        // only ever moves the cursor backwards, so one pass is enough
+        graph.offsets.resize(n + 1);
+        graph.neighbors.resize(total);
+        size_t cursor = 0;
+        for (int v = 0; v < n; v++) {
+            size_t rowStart = cursor;
+            for (int friendId : adjacencyList.at(graph.userIds[v])) {
+                int u = graph.denseIds.at(friendId);
+                if (u != v) graph.neighbors[cursor++] = u;
+            }
+            auto rowBegin = graph.neighbors.begin() + rowStart;
+            sort(rowBegin, graph.neighbors.begin() + cursor);
+            cursor = unique(rowBegin, graph.neighbors.begin() + cursor) - graph.neighbors.begin();
+            graph.offsets[v + 1] = cursor;
+        }
+        graph.neighbors.resize(cursor);
+        graph.neighbors.shrink_to_fit();
+        return graph;
+    }
+    
+    int vertexCount() const { return userIds.size(); }
+    size_t edgeCount() const { return neighbors.size() / 2; }
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+    
+    Range neighborsOf(int v) const {
+        return {neighbors.data() + offsets[v], neighbors.data() + offsets[v + 1]};
+    }
+    
+    bool hasEdge(int v, int u) const {
+        Range row = neighborsOf(v);
+        return binary_search(row.begin(), row.end(), u);
+    }
+    
+    // -1 when the user is not part of the snapshot
+    int toDense(int userId) const {
+        auto it = denseIds.find(userId);
+        return it == denseIds.end() ? -1 : it->second;
+    }
+    
+    int toUser(int v) const { return userIds[v]; }
+};
+
+// Direction-optimizing BFS (Beamer et al.) over a CSR snapshot
+// Each level runs either top-down (frontier vertices claim unvisited
+// neighbors with an atomic fetch_or on the visited bitmap) or bottom-up
+// (every unvisited vertex scans its row for a parent in the frontier bitmap
+// and stops at the first hit). Top-down wins while the frontier is small;
+// bottom-up wins once the frontier's edges outnumber a fraction of the
+// unexplored ones, which on small-world graphs is the middle few levels.
+// Work within a level is split across threads, so large levels scale with
+// the core count.
+class DirectionOptimizingBFS {
+    const CSRGraph& graph;
+    int numThreads;
+    vector<atomic<uint64_t>> visited;
+    vector<uint64_t> frontierBits, nextBits;
+    vector<int> frontier;
+    vector<vector<int>> localNext;
+    
+    // Switching thresholds from the paper: go bottom-up when frontier edges
+    // exceed unexplored edges / ALPHA, back to top-down once a shrinking
+    // frontier holds fewer than V / BETA vertices
+    static constexpr size_t ALPHA = 14;
+    static constexpr size_t BETA = 24;
+    
+    // Fewest edges or vertices worth a thread (see threadsFor)
+    static constexpr size_t MIN_WORK_PER_THREAD = 4096;
+    
+    bool tryVisit(int v) {
+        uint64_t bit = 1ULL << (v & 63);
+        atomic<uint64_t>& word = visited[v >> 6];
+        if (word.load(memory_order_relaxed) & bit) return false;
+        return !(word.fetch_or(bit, memory_order_relaxed) & bit);
+    }
+    
+    // Threads own contiguous slices of the frontier; each level's output is
+    // sorted so results do not depend on thread timing
+    void topDownStep(size_t frontierEdges) {
+        int threads = threadsFor(numThreads, frontierEdges, MIN_WORK_PER_THREAD);
+        parallelFor(threads, [&](int t) {
+            size_t lo = frontier.size() * t / threads;
+            size_t hi = frontier.size() * (t + 1) / threads;
+            vector<int>& out = localNext[t];
+            out.clear();
+            for (size_t i = lo; i < hi; i++) {
+                for (int neighbor : graph.neighborsOf(frontier[i])) {
+                    if (tryVisit(neighbor)) out.push_back(neighbor);
+                }
+            }
+        });
+        frontier.clear();
+        for (int t = 0; t < threads; t++) {
+            frontier.insert(frontier.end(), localNext[t].begin(), localNext[t].end());
+        }
+        sort(frontier.begin(), frontier.end());
+    }
+    
+    // Threads own contiguous ranges of bitmap words, so visited and next
+    // bits are written without contention and the output is already sorted
+    void bottomUpStep() {
+        int n = graph.vertexCount();
+        size_t words = visited.size();
+        int threads = threadsFor(numThreads, n, MIN_WORK_PER_THREAD);
+        parallelFor(threads, [&](int t) {
+            size_t lo = words * t / threads;
+            size_t hi = words * (t + 1) / threads;
+            vector<int>& out = localNext[t];
+            out.clear();
+            for (size_t w = lo; w < hi; w++) {
+                uint64_t seen = visited[w].load(memory_order_relaxed);
+                uint64_t unvisited = ~seen;
+                if (w == words - 1 && n % 64) unvisited &= (1ULL << (n % 64)) - 1;
+                uint64_t found = 0;
+                while (unvisited) {
+                    int bit = __builtin_ctzll(unvisited);
+                    unvisited &= unvisited - 1;
+                    int v = w * 64 + bit;
+                    for (int neighbor : graph.neighborsOf(v)) {
+                        if (frontierBits[neighbor >> 6] >> (neighbor & 63) & 1) {
+                            found |= 1ULL << bit;
+                            out.push_back(v);
+                            break;
+                        }
+                    }
+                }
+                nextBits[w] = found;
+                visited[w].store(seen | found, memory_order_relaxed);
+            }
+        });
+        swap(frontierBits, nextBits);
+        frontier.clear();
+        for (int t = 0; t < threads; t++) {
+            frontier.insert(frontier.end(), localNext[t].begin(), localNext[t].end());
+        }
+    }
+    
+public:
+    explicit DirectionOptimizingBFS(const CSRGraph& graph, int numThreads = 0)
+        : graph(graph), numThreads(resolveThreads(numThreads)),
+          visited((graph.vertexCount() + 63) / 64),
+          frontierBits(visited.size()), nextBits(visited.size()),
+          localNext(this->numThreads) {}
+    
+    // Expands levels 1..maxDepth from source (maxDepth < 0 for no bound) and
+    // calls visit(depth, vertices) once per non-empty level, with that
+    // level's dense vertex IDs in increasing order
+    template<typename F>
+    void run(int source, int maxDepth, F visit) {
+        for (atomic<uint64_t>& word : visited) word.store(0, memory_order_relaxed);
+        tryVisit(source);
+        frontier.assign(1, source);
+        
+        bool bottomUp = false;
+        size_t frontierEdges = graph.degree(source);
+        size_t unexploredEdges = graph.neighbors.size() - frontierEdges;
+        size_t previousSize = 0;
+        
+        for (int depth = 1; maxDepth < 0 || depth <= maxDepth; depth++) {
+            if (!bottomUp && frontierEdges > unexploredEdges / ALPHA) {
+                fill(frontierBits.begin(), frontierBits.end(), 0);
+                for (int v : frontier) frontierBits[v >> 6] |= 1ULL << (v & 63);
+                bottomUp = true;
+            } else if (bottomUp && frontier.size() < previousSize &&
+                       frontier.size() < graph.vertexCount() / BETA) {
+                bottomUp = false;
+            }
+            
+            previousSize = frontier.size();
+            if (bottomUp) {
+                bottomUpStep();
+            } else {
+                topDownStep(frontierEdges);
+            }
+            if (frontier.empty()) break;
+            
+            frontierEdges = 0;
+            for (int v : frontier) frontierEdges += graph.degree(v);
+            unexploredEdges -= min(unexploredEdges, frontierEdges);
+            visit(depth, frontier);
+        }
+    }
+};
+
+// Triangle counts and clustering coefficients for every vertex of a snapshot
+struct ClusteringStats {
+    vector<uint64_t> triangles;    // per dense vertex
+    vector<double> local;          // per dense vertex; 0 below degree 2
+    uint64_t totalTriangles = 0;
+    double globalCoefficient = 0;  // 3 * triangles / connected triples
+    double averageCoefficient = 0; // mean of local coefficients
+};
+
+// Counts every triangle exactly once by orienting each edge from the endpoint
+// with lower (degree, ID) to the higher one. Each triangle is then found at
+// its lowest vertex v, as the intersection of v's and u's out-rows for one
+// out-neighbor u. Out-rows have at most O(sqrt(E)) entries, so hubs never
+// pay d^2, and they stay sorted, so intersection is a linear merge. Vertices
+// are claimed in chunks by all threads; per-vertex counts are atomic.
+ClusteringStats countTriangles(const CSRGraph& graph, int numThreads = 0) {
+    const int CHUNK = 256;
+    int n = graph.vertexCount();
+    numThreads = threadsFor(numThreads, n, CHUNK);
+    auto precedes = [&](int a, int b) {
+        int degreeA = graph.degree(a), degreeB = graph.degree(b);
+        return degreeA != degreeB ? degreeA < degreeB : a < b;
+    };
+    
+    // Oriented CSR: the same layout as the snapshot, keeping only u > v
+    vector<size_t> offsets(n + 1, 0);
+    parallelFor(numThreads, [&](int t) {
+        for (int v = (long long)n * t / numThreads; v < (long long)n * (t + 1) / numThreads; v++) {
+            for (int u : graph.neighborsOf(v)) offsets[v + 1] += precedes(v, u);
+        }
+    });
+    for (int v = 0; v < n; v++) offsets[v + 1] += offsets[v];
+    vector<int> out(offsets[n]);
+    parallelFor(numThreads, [&](int t) {
+        for (int v = (long long)n * t / numThreads; v < (long long)n * (t + 1) / numThreads; v++) {
+            size_t cursor = offsets[v];
+            for (int u : graph.neighborsOf(v)) {
+                if (precedes(v, u)) out[cursor++] = u;
+            }
+        }
+    });
+    
+    vector<atomic<uint64_t>> triangles(n);
+    atomic<int> nextVertex{0};
+    parallelFor(numThreads, [&](int) {
+        while (true) {
+            int begin = nextVertex.fetch_add(CHUNK);
+            if (begin >= n) break;
+            int end = min(n, begin + CHUNK);
+            for (int v = begin; v < end; v++) {
+                const int* rowV = out.data() + offsets[v];
+                const int* endV = out.data() + offsets[v + 1];
+                uint64_t found = 0;
+                for (const int* p = rowV; p != endV; p++) {
+                    int u = *p;
+                    const int* a = rowV;
+                    const int* b = out.data() + offsets[u];
+                    const int* endU = out.data() + offsets[u + 1];
+                    uint64_t shared = 0;
+                    while (a != endV && b != endU) {
+                        if (*a < *b) {
+                            a++;
+                        } else if (*b < *a) {
+                            b++;
+                        } else {
+                            triangles[*a].fetch_add(1, memory_order_relaxed);
+                            shared++;
+                            a++;
+                            b++;
+                        }
+                    }
+                    if (shared) triangles[u].fetch_add(shared, memory_order_relaxed);
+                    found += shared;
+                }
+                if (found) triangles[v].fetch_add(found, memory_order_relaxed);
+            }
+        }
+    });
+    
+    ClusteringStats stats;
+    stats.triangles.resize(n);
+    stats.local.resize(n);
+    uint64_t corners = 0, triples = 0;
+    double localSum = 0;
+    for (int v = 0; v < n; v++) {
+        uint64_t t = triangles[v].load(memory_order_relaxed);
+        uint64_t d = graph.degree(v);
+        uint64_t pairs = d * (d - 1) / 2;
+        stats.triangles[v] = t;
+        stats.local[v] = pairs ? (double)t / pairs : 0.0;
+        corners += t;
+        triples += pairs;
+        localSum += stats.local[v];
+    }
+    stats.totalTriangles = corners / 3;
+    stats.globalCoefficient = triples ? (double)corners / triples : 0.0;
+    stats.averageCoefficient = n ? localSum / n : 0.0;
+    return stats;
+}
+
+// Fully dynamic connectivity (Holm, de Lichtenberg and Thorup)
+// Every edge has a level, starting at 0. Level i keeps a spanning forest of
+// the tree edges with level >= i, where each tree is an Euler tour stored in a
+// splay tree. Deleting a tree edge searches for a replacement edge, walking
+// from the edge's level down to 0. At each level it first promotes the
+// smaller side's tree edges, then either reconnects through one of that
+// side's non-tree edges or promotes the non-tree edge. Levels never exceed
+// log2(V), so updates cost O(log^2 V) amortized. Vertices are arbitrary
+// integer IDs, added on demand.
+class DynamicConnectivity {
+    // One position in an Euler tour: a vertex occurrence or one arc of a tree edge
+    struct Node {
+        Node* left = nullptr;
+        Node* right = nullptr;
+        Node* parent = nullptr;
+        int vertex = -1;       // -1 for arcs
+        int from = -1, to = -1; // arc endpoints
+        int size = 0;          // vertex occurrences in this subtree
+        uint8_t flags = 0;
+        uint8_t subtreeFlags = 0;
+    };
+    
+    // The arc of a tree edge whose own level is this level
+    static constexpr uint8_t TREE_EDGE = 1;
+    // A vertex with non-tree edges at this level
+    static constexpr uint8_t NONTREE_EDGES = 2;
+    
+    struct Edge {
+        int level = 0;
+        int count = 1;           // parallel friendships share one edge
+        bool tree = false;
+        size_t slot[2] = {0, 0}; // positions in the endpoints' non-tree lists
+        vector<pair<Node*, Node*>> arcs; // per level 0..level for tree edges
+    };
+    
+    unordered_map<int, int> index;          // user ID -> vertex
+    vector<int> ids;                        // vertex -> user ID
+    vector<vector<Node*>> vertexNodes;      // [vertex][level], created on demand
+    vector<vector<vector<int>>> nontree;    // [vertex][level] -> other endpoints
+    unordered_map<uint64_t, Edge> edges;
+    deque<Node> pool;
+    vector<Node*> freeNodes;
+    int components = 0;
+    
+    static uint64_t key(int x, int y) {
+        if (x > y) swap(x, y);
+        return (uint64_t)x << 32 | (uint32_t)y;
+    }
+    
+    // Splay tree primitives
+    
+    static void update(Node* x) {
+        x->size = (x->vertex >= 0);
+        x->subtreeFlags = x->flags;
+        if (x->left) {
+            x->size += x->left->size;
+            x->subtreeFlags |= x->left->subtreeFlags;
+        }
+        if (x->right) {
+            x->size += x->right->size;
+            x->subtreeFlags |= x->right->subtreeFlags;
+        }
+    }
+    
+    static void rotate(Node* x) {
+        Node* p = x->parent;
+        Node* g = p->parent;
+        if (p->left == x) {
+            p->left = x->right;
+            if (x->right) x->right->parent = p;
+            x->right = p;
+        } else {
+            p->right = x->left;
+            if (x->left) x->left->parent = p;
+            x->left = p;
+        }
+        p->parent = x;
+        x->parent = g;
+        if (g) {
+            if (g->left == p) g->left = x;
+            else g->right = x;
+        }
+        update(p);
+        update(x);
+    }
+    
+    static Node* splay(Node* x) {
+        while (x->parent) {
+            Node* p = x->parent;
+            Node* g = p->parent;
+            if (g) rotate((g->left == p) == (p->left == x) ? p : x);
+            rotate(x);
+        }
+        return x;
+    }
+    
+    static Node* join(Node* a, Node* b) {
+        if (!a) return b;
+        if (!b) return a;
+        while (a->right) a = a->right;
+        splay(a);
+        a->right = b;
+        b->parent = a;
+        update(a);
+        return a;
+    }
+    
+    // Detaches and returns everything before x; x becomes the root of the rest
+    static Node* splitBefore(Node* x) {
+        splay(x);
+        Node* left = x->left;
+        if (left) {
+            left->parent = nullptr;
+            x->left = nullptr;
+            update(x);
+        }
+        return left;
+    }
+    
+    // Detaches and returns everything after x; x becomes the root of the rest
+    static Node* splitAfter(Node* x) {
+        splay(x);
+        Node* right = x->right;
+        if (right) {
+            right->parent = nullptr;
+            x->right = nullptr;
+            update(x);
+        }
+        return right;
+    }
+    
+    static bool sameTree(Node* x, Node* y) {
+        if (x == y) return true;
+        splay(x);
+        splay(y);
+        return x->parent != nullptr;
+    }
+    
+    // Rotates the tour so it starts at x
+    static Node* reroot(Node* x) {
+        Node* before = splitBefore(x);
+        return join(x, before);
+    }
+    
+    static void setFlag(Node* x, uint8_t flag, bool on) {
+        splay(x);
+        if (on) x->flags |= flag;
+        else x->flags &= ~flag;
+        update(x);
+    }
+    
+    // First node carrying flag in the tree rooted at root
+    static Node* findFlag(Node* root, uint8_t flag) {
+        Node* x = root;
+        while (true) {
+            if (x->left && (x->left->subtreeFlags & flag)) x = x->left;
+            else if (x->flags & flag) return splay(x);
+            else x = x->right;
+        }
+    }
+    
+    // Euler tour forest operations
+    
+    Node* allocate() {
+        if (!freeNodes.empty()) {
+            Node* x = freeNodes.back();
+            freeNodes.pop_back();
+            *x = Node();
+            return x;
+        }
+        pool.emplace_back();
+        return &pool.back();
+    }
+    
+    Node* vertexNode(int x, int level) {
+        vector<Node*>& nodes = vertexNodes[x];
+        if ((int)nodes.size() <= level) nodes.resize(level + 1, nullptr);
+        if (!nodes[level]) {
+            Node* node = allocate();
+            node->vertex = x;
+            node->size = 1;
+            nodes[level] = node;
+        }
+        return nodes[level];
+    }
+    
+    bool connected(int x, int y, int level) {
+        return sameTree(vertexNode(x, level), vertexNode(y, level));
+    }
+    
+    int treeSize(int x, int level) {
+        return splay(vertexNode(x, level))->size;
+    }
+    
+    // Adds tree edge (x, y) to the forest of one level; the tours
+    // ...x... and ...y... become x... (x->y) y... (y->x)
+    pair<Node*, Node*> link(int x, int y, int level) {
+        Node* forward = allocate();
+        Node* backward = allocate();
+        forward->from = backward->to = x;
+        forward->to = backward->from = y;
+        Node* tourX = reroot(vertexNode(x, level));
+        Node* tourY = reroot(vertexNode(y, level));
+        join(join(join(tourX, forward), tourY), backward);
+        return {forward, backward};
+    }
+    
+    // Removes both arcs of a tree edge; the tour A a B b C splits into A C and B
+    void cut(Node* a, Node* b) {
+        Node* left = splitBefore(a);
+        if (!sameTree(a, b)) {
+            // b was splayed to the root of the detached prefix
+            join(b, a);
+            swap(a, b);
+            left = splitBefore(a);
+        }
+        Node* right = splitAfter(b);
+        splitBefore(b);
+        splitAfter(a);
+        join(left, right);
+        freeNodes.push_back(a);
+        freeNodes.push_back(b);
+    }
+    
+    // Non-tree edge lists
+    
+    vector<int>& nontreeList(int x, int level) {
+        vector<vector<int>>& levels = nontree[x];
+        if ((int)levels.size() <= level) levels.resize(level + 1);
+        return levels[level];
+    }
+    
+    void addNontree(int x, int y, Edge& edge) {
+        int ends[2] = {x, y};
+        for (int side = 0; side < 2; side++) {
+            int self = ends[side], other = ends[1 - side];
+            vector<int>& list = nontreeList(self, edge.level);
+            edge.slot[self > other] = list.size();
+            list.push_back(other);
+            if (list.size() == 1) setFlag(vertexNode(self, edge.level), NONTREE_EDGES, true);
+        }
+    }
+    
+    // Swap-removes both entries of (x, y) and fixes the slot of whichever edge moved
+    void removeNontree(int x, int y, Edge& edge) {
+        int ends[2] = {x, y};
+        for (int side = 0; side < 2; side++) {
+            int self = ends[side], other = ends[1 - side];
+            vector<int>& list = nontreeList(self, edge.level);
+            size_t slot = edge.slot[self > other];
+            int moved = list.back();
+            list[slot] = moved;
+            list.pop_back();
+            if (moved != other) edges.at(key(self, moved)).slot[self > moved] = slot;
+            if (list.empty()) setFlag(vertexNode(self, edge.level), NONTREE_EDGES, false);
+        }
+    }
+    
+    void makeTree(int x, int y, Edge& edge) {
+        edge.tree = true;
+        edge.arcs.clear();
+        for (int level = 0; level <= edge.level; level++) {
+            edge.arcs.push_back(link(x, y, level));
+        }
+        setFlag(edge.arcs.back().first, TREE_EDGE, true);
+    }
+    
+    // Looks for an edge reconnecting x's and y's trees, from level down to 0
+    bool replace(int x, int y, int level) {
+        for (int i = level; i >= 0; i--) {
+            int small = treeSize(x, i) <= treeSize(y, i) ? x : y;
+            
+            // The smaller tree has at most half the vertices of the tree it
+            // was cut from, so its tree edges may move up a level
+            while (true) {
+                Node* root = splay(vertexNode(small, i));
+                if (!(root->subtreeFlags & TREE_EDGE)) break;
+                Node* arc = findFlag(root, TREE_EDGE);
+                Edge& edge = edges.at(key(arc->from, arc->to));
+                setFlag(arc, TREE_EDGE, false);
+                edge.level = i + 1;
+                edge.arcs.push_back(link(arc->from, arc->to, i + 1));
+                setFlag(edge.arcs.back().first, TREE_EDGE, true);
+            }
+            
+            while (true) {
+                Node* root = splay(vertexNode(small, i));
+                if (!(root->subtreeFlags & NONTREE_EDGES)) break;
+                int w = findFlag(root, NONTREE_EDGES)->vertex;
+                while (!nontreeList(w, i).empty()) {
+                    int z = nontreeList(w, i).back();
+                    Edge& edge = edges.at(key(w, z));
+                    removeNontree(w, z, edge);
+                    if (connected(w, z, i)) {
+                        edge.level = i + 1;
+                        addNontree(w, z, edge);
+                    } else {
+                        makeTree(w, z, edge);
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+    
+    int vertexOf(int userId) const {
+        auto it = index.find(userId);
+        return it == index.end() ? -1 : it->second;
+    }
+    
+public:
+    void addVertex(int userId) {
+        if (index.count(userId)) return;
+        int x = ids.size();
+        index[userId] = x;
+        ids.push_back(userId);
+        vertexNodes.emplace_back();
+        nontree.emplace_back();
+        vertexNode(x, 0);
+        components++;
+    }
+    
+    void addEdge(int userId1, int userId2) {
+        addVertex(userId1);
+        addVertex(userId2);
+        int x = index[userId1], y = index[userId2];
+        if (x == y) return;
+        
+        auto [it, inserted] = edges.try_emplace(key(x, y));
+        Edge& edge = it->second;
+        if (!inserted) {
+            edge.count++;
+            return;
+        }
+        if (connected(x, y, 0)) {
+            addNontree(x, y, edge);
+        } else {
+            makeTree(x, y, edge);
+            components--;
+        }
+    }
+    
+    // Removes one copy of the edge; returns false if it was not present
+    bool removeEdge(int userId1, int userId2) {
+        int x = vertexOf(userId1), y = vertexOf(userId2);
+        if (x < 0 || y < 0 || x == y) return false;
+        auto it = edges.find(key(x, y));
+        if (it == edges.end()) return false;
+        Edge& edge = it->second;
+        if (--edge.count > 0) return true;
+        
+        if (!edge.tree) {
+            removeNontree(x, y, edge);
+            edges.erase(it);
+            return true;
+        }
+        
+        int level = edge.level;
+        for (auto [forward, backward] : edge.arcs) cut(forward, backward);
+        edges.erase(it);
+        if (!replace(x, y, level)) components++;
+        return true;
+    }
+    
+    // Bulk insertion of new edges whose spanning forest is already known,
+    // e.g. from a ConcurrentUnionFind pass. Forest edges must join different
+    // components, and every other edge must join vertices the forest
+    // connects. Skips the per-edge connectivity checks of addEdge.
+    void addEdges(const vector<pair<int, int>>& forest, const vector<pair<int, int>>& others) {
+        edges.reserve(edges.size() + forest.size() + others.size());
+        for (auto [userId1, userId2] : forest) {
+            int x = index.at(userId1), y = index.at(userId2);
+            makeTree(x, y, edges[key(x, y)]);
+            components--;
+        }
+        for (auto [userId1, userId2] : others) {
+            int x = index.at(userId1), y = index.at(userId2);
+            addNontree(x, y, edges[key(x, y)]);
+        }
+    }
+    
+    bool connected(int userId1, int userId2) {
+        int x = vertexOf(userId1), y = vertexOf(userId2);
+        if (x < 0 || y < 0) return false;
+        return connected(x, y, 0);
+    }
+    
+    int componentSize(int userId) {
+        int x = vertexOf(userId);
+        return x < 0 ? 0 : treeSize(x, 0);
+    }
+    
+    int componentCount() const { return components; }
+    
+    // Components sorted by user ID, ordered by their smallest member. The
+    // first node of a level-0 tour identifies its component.
+    vector<vector<int>> componentList() {
+        vector<int> sorted = ids;
+        sort(sorted.begin(), sorted.end());
+        unordered_map<Node*, int> componentIndex;
+        vector<vector<int>> result;
+        for (int userId : sorted) {
+            Node* first = splay(vertexNode(index[userId], 0));
+            while (first->left) first = first->left;
+            splay(first);
+            auto [it, inserted] = componentIndex.try_emplace(first, result.size());
+            if (inserted) result.emplace_back();
+            result[it->second].push_back(userId);
+        }
+        return result;
+    }
+};
+
+// Bulk edge loading
+
+// (u, v) pairs parsed by one loader thread
+using EdgeChunk = vector<pair<int, int>>;
+
+// Parses "u v" lines separated by spaces, tabs or a comma. Blank lines and
+// lines starting with '#' or '%' are ignored; anything else that is not two
+// integers counts as malformed.
+void parseTextEdges(const char* p, const char* end, EdgeChunk& out, size_t& malformed) {
+    while (p < end) {
+        const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+        if (!lineEnd) lineEnd = end;
+        
+        long long values[2];
+        int found = 0;
+        while (found < 2) {
+            while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r')) p++;
+            if (p == lineEnd || *p == '#' || *p == '%') break;
+            bool negative = *p == '-';
+            if (negative) p++;
+            if (p == lineEnd || !isdigit((unsigned char)*p)) {
+                found = -1;
+                break;
+            }
+            long long value = 0;
+            while (p < lineEnd && isdigit((unsigned char)*p) && value <= INT_MAX) {
+                value = value * 10 + (*p++ - '0');
+            }
+            if (value > INT_MAX) {
+                found = -1;
+                break;
+            }
+            values[found++] = negative ? -value : value;
+        }
+        
+        if (found == 2) out.push_back({(int)values[0], (int)values[1]});
+        else if (found != 0) malformed++;
+        p = lineEnd + 1;
+    }
+}
+
+// Merges chunks of dense (u, v) edges into graph's rows with a parallel
+// counting sort. Degrees are counted with atomic increments and prefix-summed
+// into row offsets; existing rows are copied in, and new edges are scattered
+// behind them through atomic per-row cursors. Finally every row is sorted and
+// deduplicated, and the rows are compacted into one array.
+void mergeEdges(CSRGraph& graph, const vector<EdgeChunk>& chunks, int numThreads) {
+    int n = graph.vertexCount();
+    vector<atomic<size_t>> cursor(n);
+    parallelFor(chunks.size(), [&](int t) {
+        for (auto [u, v] : chunks[t]) {
+            cursor[u].fetch_add(1, memory_order_relaxed);
+            cursor[v].fetch_add(1, memory_order_relaxed);
+        }
+    });
+    
+    vector<size_t> offsets(n + 1, 0);
+    for (int v = 0; v < n; v++) {
+        offsets[v + 1] = offsets[v] + graph.degree(v) + cursor[v].load(memory_order_relaxed);
+    }
+    
+    vector<int> merged(offsets[n]);
+    parallelFor(numThreads, [&](int t) {
+        for (int v = (long long)n * t / numThreads; v < (long long)n * (t + 1) / numThreads; v++) {
+            CSRGraph::Range row = graph.neighborsOf(v);
+            copy(row.begin(), row.end(), merged.begin() + offsets[v]);
+            cursor[v].store(offsets[v] + graph.degree(v), memory_order_relaxed);
+        }
+    });
+    parallelFor(chunks.size(), [&](int t) {
+        for (auto [u, v] : chunks[t]) {
+            merged[cursor[u].fetch_add(1, memory_order_relaxed)] = v;
+            merged[cursor[v].fetch_add(1, memory_order_relaxed)] = u;
+        }
+    });
+    
+    // Degrees are skewed, so rows are claimed in small chunks
+    const int CHUNK = 1024;
+    vector<size_t> kept(n);
+    atomic<int> nextVertex{0};
+    parallelFor(numThreads, [&](int) {
+        while (true) {
+            int begin = nextVertex.fetch_add(CHUNK);
+            if (begin >= n) break;
+            for (int v = begin; v < min(n, begin + CHUNK); v++) {
+                auto rowBegin = merged.begin() + offsets[v];
+                auto rowEnd = merged.begin() + offsets[v + 1];
+                sort(rowBegin, rowEnd);
+                kept[v] = unique(rowBegin, rowEnd) - rowBegin;
+            }
+        }
+    });
+    
+    graph.offsets.assign(n + 1, 0);
+    for (int v = 0; v < n; v++) graph.offsets[v + 1] = graph.offsets[v] + kept[v];
+    graph.neighbors.assign(graph.offsets[n], 0);
+    parallelFor(numThreads, [&](int t) {
+        for (int v = (long long)n * t / numThreads; v < (long long)n * (t + 1) / numThreads; v++) {
+            auto rowBegin = merged.begin() + offsets[v];
+            copy(rowBegin, rowBegin + kept[v], graph.neighbors.begin() + graph.offsets[v]);
+        }
+    });
+}
+
 class SocialNetwork {
-    unordered_map<int, User> users;
+protected:
+    UserStore users;
     unordered_map<int, vector<int>> adjacencyList;
-    UnionFind communities;
+    DynamicConnectivity communities;
     int nextUserId;
+    // Per-call log lines from addUser/addFriendship/removeFriendship
+    bool verbose = true;
+    
+    // Read-only CSR view used by all traversals. Mutations only mark it
+    // stale; the first query afterwards rebuilds it in O(V + E log d), so
+    // bulk updates followed by queries pay for one rebuild.
+    mutable CSRGraph csr;
+    mutable bool csrValid = false;
+    // Bumped on every rebuild, so results derived from a snapshot can tell
+    // when they are stale
+    mutable uint64_t snapshotVersion = 0;
+    
+    void invalidateSnapshot() { csrValid = false; }
+    
+    // Interest signatures and LSH buckets, one user added per addUser
+    InterestIndex interestIndex;
+    
+    // Fewest file bytes worth a loader thread (see threadsFor)
+    static constexpr size_t LOAD_BYTES_PER_THREAD = 1 << 20;
+    
+    // Replaces the connectivity structure in one pass over the snapshot. A
+    // concurrent union-find picks a spanning forest in parallel, so every
+    // edge is then inserted without a connectivity check.
+    void rebuildCommunities(int numThreads) {
+        const CSRGraph& graph = csr;
+        int n = graph.vertexCount();
+        ConcurrentUnionFind forest(n);
+        vector<EdgeChunk> treeEdges(numThreads), otherEdges(numThreads);
+        parallelFor(numThreads, [&](int t) {
+            for (int v = (long long)n * t / numThreads; v < (long long)n * (t + 1) / numThreads; v++) {
+                for (int u : graph.neighborsOf(v)) {
+                    if (u < v) continue;
+                    EdgeChunk& out = forest.unite(v, u) ? treeEdges[t] : otherEdges[t];
+                    out.push_back({graph.toUser(v), graph.toUser(u)});
+                }
+            }
+        });
+        for (int t = 1; t < numThreads; t++) {
+            treeEdges[0].insert(treeEdges[0].end(), treeEdges[t].begin(), treeEdges[t].end());
+            otherEdges[0].insert(otherEdges[0].end(), otherEdges[t].begin(), otherEdges[t].end());
+        }
+        
+        communities = DynamicConnectivity();
+        for (int userId : graph.userIds) communities.addVertex(userId);
+        communities.addEdges(treeEdges[0], otherEdges[0]);
+    }
+    
+    // Users claimed at a time by each recommendFriendsBatch thread
+    static constexpr size_t RECOMMEND_CHUNK = 64;
+    
+    // Mutual-friend counts indexed by dense ID. EXCLUDED marks the user and
+    // their friends; only touched entries are reset after each user.
+    struct RecommendScratch {
+        static constexpr int EXCLUDED = -1;
+        vector<int> count;
+        vector<int> candidates;
+        vector<double> interestScore; // recommendFriendsHybrid only; zero between users
+        
+        // Every count is zero between users, so growing with the graph is
+        // the only O(V) step
+        void fit(int vertexCount) {
+            if ((size_t)vertexCount > count.size()) count.resize(vertexCount, 0);
+        }
+    };
+    
+    // One scratch per recommendation thread, kept across calls so a
+    // single-user query only pays for the entries it touches
+    vector<RecommendScratch> recommendScratch;
+    
+    // Calls f on every neighbor of v, or on an evenly strided sample of about
+    // maxDegree of them when the row is longer
+    template<typename F>
+    static void forEachSampled(const CSRGraph& graph, int v, int maxDegree, F f) {
+        CSRGraph::Range row = graph.neighborsOf(v);
+        size_t degree = row.end() - row.begin();
+        if (maxDegree <= 0 || degree <= (size_t)maxDegree) {
+            for (int u : row) f(u);
+            return;
+        }
+        size_t stride = (degree + maxDegree - 1) / maxDegree;
+        for (size_t i = (uint32_t)v * 2654435761u % stride; i < degree; i += stride) {
+            f(row.begin()[i]);
+        }
+    }
+    
+    // Fills s.candidates with the friends-of-friends of source and s.count
+    // with their mutual friend counts; source and its friends are EXCLUDED.
+    // clearMutualFriends must run before the scratch is reused.
+    static void countMutualFriends(const CSRGraph& graph, int source, int maxDegree,
+                                   RecommendScratch& s) {
+        const int EXCLUDED = RecommendScratch::EXCLUDED;
+        s.count[source] = EXCLUDED;
+        for (int friendId : graph.neighborsOf(source)) s.count[friendId] = EXCLUDED;
+        
+        s.candidates.clear();
+        forEachSampled(graph, source, maxDegree, [&](int friendId) {
+            forEachSampled(graph, friendId, maxDegree, [&](int mutualFriend) {
+                int& count = s.count[mutualFriend];
+                if (count == EXCLUDED) return;
+                if (count++ == 0) s.candidates.push_back(mutualFriend);
+            });
+        });
+    }
+    
+    static void clearMutualFriends(const CSRGraph& graph, int source, RecommendScratch& s) {
+        for (int candidate : s.candidates) s.count[candidate] = 0;
+        for (int friendId : graph.neighborsOf(source)) s.count[friendId] = 0;
+        s.count[source] = 0;
+    }
+    
+    static void topMutualFriends(const CSRGraph& graph, int source, int k, int maxDegree,
+                                 RecommendScratch& s, vector<int>& out) {
+        countMutualFriends(graph, source, maxDegree, s);
+        
+        // Dense IDs follow user ID order, so (count, dense ID) ranks like
+        // (count, user ID)
+        auto better = [&](int a, int b) {
+            return s.count[a] != s.count[b] ? s.count[a] > s.count[b] : a > b;
+        };
+        size_t top = min<size_t>(k, s.candidates.size());
+        if (top < s.candidates.size()) {
+            nth_element(s.candidates.begin(), s.candidates.begin() + top, s.candidates.end(), better);
+        }
+        sort(s.candidates.begin(), s.candidates.begin() + top, better);
+        
+        out.clear();
+        for (size_t i = 0; i < top; i++) out.push_back(graph.toUser(s.candidates[i]));
+        
+        clearMutualFriends(graph, source, s);
+    }
+    
+    // Reusable shortest-path state indexed by dense vertex ID. A vertex
+    // belongs to the forward or backward search of the current query only if
+    // its mark equals that side's stamp, so starting a query bumps the epoch
+    // instead of clearing O(V) memory, and the frontiers keep their capacity.
+    struct PathScratch {
+        vector<uint32_t> mark;
+        vector<int> parent;
+        vector<int> frontier[2];
+        vector<int> next;
+        uint32_t epoch = 0;
+        
+        // Returns the forward stamp; the backward stamp is one higher
+        uint32_t begin(int vertexCount) {
+            if ((int)mark.size() < vertexCount) {
+                mark.resize(vertexCount, 0);
+                parent.resize(vertexCount);
+            }
+            if (epoch >= UINT32_MAX - 2) {
+                fill(mark.begin(), mark.end(), 0);
+                epoch = 0;
+            }
+            epoch += 2;
+            return epoch;
+        }
+    };
+    PathScratch pathScratch;
+    
+    // Stitches source..forwardEnd and backwardEnd..target along the parent
+    // links of each side
+    vector<int> joinPaths(const CSRGraph& graph, int forwardEnd, int backwardEnd) const {
+        vector<int> path;
+        for (int node = forwardEnd; node != -1; node = pathScratch.parent[node]) {
+            path.push_back(graph.toUser(node));
+        }
+        reverse(path.begin(), path.end());
+        for (int node = backwardEnd; node != -1; node = pathScratch.parent[node]) {
+            path.push_back(graph.toUser(node));
+        }
+        return path;
+    }
     
 public:
     SocialNetwork() : nextUserId(1) {}
     
+    void setVerbose(bool on) { verbose = on; }
+    
+    // Columnar attribute storage; compose its filter masks for custom scans
+    const UserStore& userStore() const { return users; }
+    
+    // MinHash/LSH index over interests, kept current by addUser
+    const InterestIndex& interests() const { return interestIndex; }
+    
+    // e.g. findUsers("Texas", "Sports"): users in Texas who like Sports
+    vector<int> findUsers(const string& location, const string& interest) const {
+        return users.usersIn(UserStore::both(users.withLocation(location), users.withInterest(interest)));
+    }
+    
+    const CSRGraph& snapshot() const {
+        if (!csrValid) {
+            csr = CSRGraph::build(adjacencyList);
+            csrValid = true;
+            snapshotVersion++;
+        }
+        return csr;
+    }
+    
     void addUser(const User& user) {
-        users[user.id] = user;
+        users.put(user);
         adjacencyList[user.id] = vector<int>();
-        communities.unite(user.id, user.id); // Initialize in its own community
-        cout << "Added user: " << user.name << " (ID: " << user.id << ")" << endl;
+        communities.addVertex(user.id);
+        invalidateSnapshot();
+        interestIndex.put(user.id, users.interestIds(user.id));
+        if (verbose) cout << "Added user: " << user.name << " (ID: " << user.id << ")" << endl;
     }
     
     void addFriendship(int userId1, int userId2) {
-        if (users.find(userId1) == users.end() || users.find(userId2) == users.end()) {
+        if (!users.has(userId1) || !users.has(userId2)) {
             cout << "Error: One or both users not found" << endl;
             return;
         }
         
         adjacencyList[userId1].push_back(userId2);
         adjacencyList[userId2].push_back(userId1);
-        communities.unite(userId1, userId2);
+        communities.addEdge(userId1, userId2);
+        invalidateSnapshot();
         
-        cout << "Added friendship: " << users[userId1].name 
-             << " <-> " << users[userId2].name << endl;
+        if (verbose) {
+            cout << "Added friendship: " << users.name(userId1) 
+                 << " <-> " << users.name(userId2) << endl;
+        }
     }
     
     void removeFriendship(int userId1, int userId2) {
-        if (users.find(userId1) == users.end() || users.find(userId2) == users.end()) {
+        if (!users.has(userId1) || !users.has(userId2)) {
             cout << "Error: One or both users not found" << endl;
             return;
         }
@@ -72,108 +1420,254 @@ public:
         auto it1 = find(adjacencyList[userId1].begin(), adjacencyList[userId1].end(), userId2);
         if (it1 != adjacencyList[userId1].end()) {
             adjacencyList[userId1].erase(it1);
+            communities.removeEdge(userId1, userId2);
         }
         
         auto it2 = find(adjacencyList[userId2].begin(), adjacencyList[userId2].end(), userId1);
         if (it2 != adjacencyList[userId2].end()) {
             adjacencyList[userId2].erase(it2);
         }
+        invalidateSnapshot();
         
-        cout << "Removed friendship: " << users[userId1].name 
-             << " <-> " << users[userId2].name << endl;
+        if (verbose) {
+            cout << "Removed friendship: " << users.name(userId1) 
+                 << " <-> " << users.name(userId2) << endl;
+        }
     }
     
-    vector<int> findShortestPath(int from, int to) {
-        if (users.find(from) == users.end() || users.find(to) == users.end()) {
-            return {};
+    enum class EdgeFormat { Text, Binary };
+    
+    struct LoadStats {
+        bool ok = false;
+        size_t edgesRead = 0;  // well-formed records in the file
+        size_t edgesAdded = 0; // friendships that were not already present
+        size_t skipped = 0;    // malformed lines, unknown users and self-loops
+    };
+    
+    // Bulk-loads friendships between existing users from an edge list. The
+    // format is text ("u v" per line) or binary (little-endian int32 pairs).
+    // The file is mapped, not read, and parsed by all threads. The edges are
+    // merged straight into the CSR snapshot by a parallel counting sort that
+    // drops duplicates, and communities are rebuilt once. Nothing is printed
+    // per edge; verbose mode adds a one-line summary.
+    LoadStats loadEdges(const string& path, EdgeFormat format = EdgeFormat::Text, int numThreads = 0) {
+        LoadStats stats;
+        MappedFile file;
+        if (!file.open(path, MADV_SEQUENTIAL)) {
+            cout << "Error: cannot map edge list " << path << endl;
+            return stats;
+        }
+        if (format == EdgeFormat::Binary && file.size() % (2 * sizeof(int32_t)) != 0) {
+            cout << "Error: " << path << " is not a binary edge list" << endl;
+            return stats;
         }
         
-        if (from == to) return {from};
-        
-        // BFS to find shortest path
-        queue<int> q;
-        unordered_map<int, int> parent;
-        unordered_map<int, bool> visited;
+        snapshot();
+        size_t edgesBefore = csr.edgeCount();
+        size_t size = file.size();
+        int threads = threadsFor(numThreads, size, LOAD_BYTES_PER_THREAD);
         
-        q.push(from);
-        visited[from] = true;
-        parent[from] = -1;
+        // Text chunks start just past a newline, so no line is split
+        auto textBoundary = [&](int t) -> size_t {
+            if (t == 0) return 0;
+            if (t == threads) return size;
+            size_t start = size * t / threads;
+            const char* newline = (const char*)memchr(file.data() + start, '\n', size - start);
+            return newline ? newline - file.data() + 1 : size;
+        };
         
-        while (!q.empty()) {
-            int current = q.front();
-            q.pop();
+        vector<EdgeChunk> chunks(threads);
+        vector<size_t> read(threads, 0), skipped(threads, 0);
+        parallelFor(threads, [&](int t) {
+            EdgeChunk& chunk = chunks[t];
+            if (format == EdgeFormat::Text) {
+                parseTextEdges(file.data() + textBoundary(t), file.data() + textBoundary(t + 1),
+                               chunk, skipped[t]);
+            } else {
+                size_t records = size / (2 * sizeof(int32_t));
+                size_t lo = records * t / threads, hi = records * (t + 1) / threads;
+                chunk.resize(hi - lo);
+                for (size_t r = lo; r < hi; r++) {
+                    int32_t record[2];
+                    memcpy(record, file.data() + r * sizeof(record), sizeof(record));
+                    chunk[r - lo] = {record[0], record[1]};
+                }
+            }
+            read[t] = chunk.size();
             
-            for (int neighbor : adjacencyList[current]) {
-                if (!visited[neighbor]) {
-                    visited[neighbor] = true;
-                    parent[neighbor] = current;
-                    q.push(neighbor);
-                    
-                    if (neighbor == to) {
-                        // Reconstruct path
-                        vector<int> path;
-                        int node = to;
-                        while (node != -1) {
-                            path.push_back(node);
-                            node = parent[node];
-                        }
-                        reverse(path.begin(), path.end());
-                        return path;
-                    }
+            // Translate to dense IDs in place, dropping unknown users and self-loops
+            size_t kept = 0;
+            for (auto [userId1, userId2] : chunk) {
+                int u = csr.toDense(userId1), v = csr.toDense(userId2);
+                if (u < 0 || v < 0 || u == v) {
+                    skipped[t]++;
+                    continue;
                 }
+                chunk[kept++] = {u, v};
             }
-        }
+            chunk.resize(kept);
+        });
         
-        return {}; // No path found
-    }
-    
-    vector<vector<int>> findCommunities() {
-        unordered_map<int, vector<int>> communityMap;
+        mergeEdges(csr, chunks, threads);
+        snapshotVersion++;
         
-        for (const auto& pair : users) {
-            int userId = pair.first;
-            int communityId = communities.find(userId);
-            communityMap[communityId].push_back(userId);
+        // The mutable lists mirror the merged rows: one assignment per user
+        for (int v = 0; v < csr.vertexCount(); v++) {
+            vector<int>& row = adjacencyList[csr.toUser(v)];
+            row.clear();
+            for (int u : csr.neighborsOf(v)) row.push_back(csr.toUser(u));
         }
+        rebuildCommunities(threads);
         
-        vector<vector<int>> communities;
-        for (const auto& pair : communityMap) {
-            communities.push_back(pair.second);
+        stats.ok = true;
+        stats.edgesRead = accumulate(read.begin(), read.end(), size_t(0));
+        stats.skipped = accumulate(skipped.begin(), skipped.end(), size_t(0));
+        stats.edgesAdded = csr.edgeCount() - edgesBefore;
+        if (verbose) {
+            cout << "Loaded " << path << ": " << stats.edgesRead << " edges read, "
+                 << stats.edgesAdded << " new, " << stats.skipped << " skipped" << endl;
         }
-        
-        return communities;
+        return stats;
     }
     
-    vector<int> recommendFriends(int userId) {
-        if (users.find(userId) == users.end()) {
+    // Bidirectional BFS: each round expands one whole level of whichever
+    // frontier is smaller, and stops at the first edge joining the two sides.
+    // On small-world graphs both searches stay near depth d/2, so a query
+    // touches about sqrt(V) vertices instead of most of the network.
+    vector<int> findShortestPath(int from, int to) {
+        const CSRGraph& graph = snapshot();
+        int source = graph.toDense(from), target = graph.toDense(to);
+        if (source < 0 || target < 0) {
             return {};
         }
         
-        unordered_set<int> currentFriends(adjacencyList[userId].begin(), adjacencyList[userId].end());
-        unordered_map<int, int> mutualFriends;
+        if (source == target) return {from};
         
-        // Find mutual friends
-        for (int friendId : adjacencyList[userId]) {
-            for (int mutualFriend : adjacencyList[friendId]) {
-                if (mutualFriend != userId && currentFriends.find(mutualFriend) == currentFriends.end()) {
-                    mutualFriends[mutualFriend]++;
+        PathScratch& s = pathScratch;
+        uint32_t mark[2];
+        mark[0] = s.begin(graph.vertexCount());
+        mark[1] = mark[0] + 1;
+        
+        s.mark[source] = mark[0];
+        s.mark[target] = mark[1];
+        s.parent[source] = s.parent[target] = -1;
+        s.frontier[0].assign(1, source);
+        s.frontier[1].assign(1, target);
+        
+        while (!s.frontier[0].empty() && !s.frontier[1].empty()) {
+            int side = s.frontier[0].size() <= s.frontier[1].size() ? 0 : 1;
+            s.next.clear();
+            for (int current : s.frontier[side]) {
+                for (int neighbor : graph.neighborsOf(current)) {
+                    if (s.mark[neighbor] == mark[side]) continue;
+                    if (s.mark[neighbor] == mark[1 - side]) {
+                        return side == 0 ? joinPaths(graph, current, neighbor)
+                                         : joinPaths(graph, neighbor, current);
+                    }
+                    s.mark[neighbor] = mark[side];
+                    s.parent[neighbor] = current;
+                    s.next.push_back(neighbor);
                 }
             }
+            swap(s.frontier[side], s.next);
         }
         
-        // Sort by number of mutual friends
-        vector<pair<int, int>> recommendations;
-        for (const auto& pair : mutualFriends) {
-            recommendations.push_back({pair.second, pair.first});
-        }
+        return {}; // No path found
+    }
+    
+    // Connected components, each sorted by user ID and ordered by their
+    // smallest member. Maintained incrementally, so this stays correct after
+    // removeFriendship without rebuilding anything.
+    vector<vector<int>> findCommunities() {
+        return communities.componentList();
+    }
+    
+    bool inSameCommunity(int userId1, int userId2) {
+        return communities.connected(userId1, userId2);
+    }
+    
+    // Friends-of-friends who are not already friends, by mutual friend count
+    // (ties: higher user ID first); pass k to keep only the top k
+    vector<int> recommendFriends(int userId, int k = INT_MAX) {
+        return recommendFriendsBatch({userId}, k, 1)[0];
+    }
+    
+    // Top-k mutual-friend candidates for each of userIds, computed in
+    // parallel. Every thread reuses its own dense counter array, so a user
+    // costs O(sum of friends' degrees) with no hashing, and only the top k
+    // candidates are sorted. With maxDegree > 0, any neighbor list longer
+    // than maxDegree is scanned at an even stride of about maxDegree entries.
+    // This bounds the work per hub user at the cost of approximate counts;
+    // existing friends are still always excluded.
+    vector<vector<int>> recommendFriendsBatch(const vector<int>& userIds, int k,
+                                              int numThreads = 0, int maxDegree = 0) {
+        const CSRGraph& graph = snapshot();
+        vector<vector<int>> result(userIds.size());
+        if (k <= 0 || userIds.empty()) return result;
         
-        sort(recommendations.rbegin(), recommendations.rend());
+        numThreads = threadsFor(numThreads, userIds.size(), 1);
+        atomic<size_t> nextUser{0};
+        if (recommendScratch.size() < (size_t)numThreads) recommendScratch.resize(numThreads);
+        parallelFor(numThreads, [&](int t) {
+            RecommendScratch& scratch = recommendScratch[t];
+            scratch.fit(graph.vertexCount());
+            // Degrees are skewed, so threads claim small chunks as they go
+            while (true) {
+                size_t begin = nextUser.fetch_add(RECOMMEND_CHUNK);
+                if (begin >= userIds.size()) break;
+                size_t end = min(userIds.size(), begin + RECOMMEND_CHUNK);
+                for (size_t i = begin; i < end; i++) {
+                    int source = graph.toDense(userIds[i]);
+                    if (source >= 0) topMutualFriends(graph, source, k, maxDegree, scratch, result[i]);
+                }
+            }
+        });
+        return result;
+    }
+    
+    // Up to k users whose interests are most like userId's, with estimated
+    // Jaccard similarity. Friendship plays no part; see recommendFriendsHybrid.
+    vector<pair<int, double>> findSimilarUsers(int userId, int k) const {
+        return interestIndex.similarUsers(userId, k);
+    }
+    
+    // Top-k non-friends scored by mutual friends + interestWeight * interest
+    // similarity. Candidates are the friends-of-friends plus the LSH
+    // candidates of userId, so someone with no mutual friends can still be
+    // recommended on shared interests alone (ties: higher user ID first).
+    vector<pair<int, double>> recommendFriendsHybrid(int userId, int k, double interestWeight = 1.0) {
+        vector<pair<int, double>> result;
+        const CSRGraph& graph = snapshot();
+        int source = graph.toDense(userId);
+        if (source < 0 || k <= 0) return result;
         
-        vector<int> result;
-        for (const auto& rec : recommendations) {
-            result.push_back(rec.second);
+        if (recommendScratch.empty()) recommendScratch.resize(1);
+        RecommendScratch& scratch = recommendScratch[0];
+        scratch.fit(graph.vertexCount());
+        if (scratch.interestScore.size() < scratch.count.size()) {
+            scratch.interestScore.resize(scratch.count.size(), 0.0);
+        }
+        countMutualFriends(graph, source, 0, scratch);
+        // LSH candidates are distinct, so each one without mutual friends is
+        // appended once
+        for (auto [otherId, similarity] : interestIndex.candidates(userId)) {
+            int other = graph.toDense(otherId);
+            if (other < 0 || scratch.count[other] == RecommendScratch::EXCLUDED) continue;
+            if (scratch.count[other] == 0) scratch.candidates.push_back(other);
+            scratch.interestScore[other] = interestWeight * similarity;
         }
+        for (int candidate : scratch.candidates) {
+            result.push_back({graph.toUser(candidate), scratch.count[candidate] + scratch.interestScore[candidate]});
+            scratch.interestScore[candidate] = 0.0;
+        }
+        clearMutualFriends(graph, source, scratch);
         
+        auto better = [](const pair<int, double>& a, const pair<int, double>& b) {
+            return a.second != b.second ? a.second > b.second : a.first > b.first;
+        };
+        size_t top = min<size_t>(k, result.size());
+        partial_sort(result.begin(), result.begin() + top, result.end(), better);
+        result.resize(top);
         return result;
     }
     
@@ -203,7 +1697,7 @@ public:
         for (size_t i = 0; i < communities.size(); i++) {
             cout << "Community " << (i + 1) << ": ";
             for (size_t j = 0; j < communities[i].size(); j++) {
-                cout << users[communities[i][j]].name;
+                cout << users.name(communities[i][j]);
                 if (j < communities[i].size() - 1) cout << ", ";
             }
             cout << endl;
@@ -211,43 +1705,48 @@ public:
     }
     
     void printUserConnections(int userId) {
-        if (users.find(userId) == users.end()) {
+        if (!users.has(userId)) {
             cout << "User not found" << endl;
             return;
         }
         
-        cout << "\n=== Connections for " << users[userId].name << " ===" << endl;
+        cout << "\n=== Connections for " << users.name(userId) << " ===" << endl;
         cout << "Direct friends (" << adjacencyList[userId].size() << "): ";
         
         for (size_t i = 0; i < adjacencyList[userId].size(); i++) {
-            cout << users[adjacencyList[userId][i]].name;
+            cout << users.name(adjacencyList[userId][i]);
             if (i < adjacencyList[userId].size() - 1) cout << ", ";
         }
         cout << endl;
         
-        vector<int> recommendations = recommendFriends(userId);
+        vector<int> recommendations = recommendFriends(userId, 5);
         if (!recommendations.empty()) {
             cout << "Friend recommendations: ";
-            for (size_t i = 0; i < min(recommendations.size(), size_t(5)); i++) {
-                cout << users[recommendations[i]].name;
-                if (i < min(recommendations.size(), size_t(5)) - 1) cout << ", ";
+            for (size_t i = 0; i < recommendations.size(); i++) {
+                cout << users.name(recommendations[i]);
+                if (i < recommendations.size() - 1) cout << ", ";
             }
             cout << endl;
         }
     }
     
     void printShortestPath(int from, int to) {
+        if (!users.has(from) || !users.has(to)) {
+            cout << "Error: One or both users not found" << endl;
+            return;
+        }
+        
         vector<int> path = findShortestPath(from, to);
         if (path.empty()) {
-            cout << "No path found between " << users[from].name 
-                 << " and " << users[to].name << endl;
+            cout << "No path found between " << users.name(from) 
+                 << " and " << users.name(to) << endl;
             return;
         }
         
-        cout << "Shortest path from " << users[from].name 
-             << " to " << users[to].name << ": ";
+        cout << "Shortest path from " << users.name(from) 
+             << " to " << users.name(to) << ": ";
         for (size_t i = 0; i < path.size(); i++) {
-            cout << users[path[i]].name;
+            cout << users.name(path[i]);
             if (i < path.size() - 1) cout << " -> ";
         }
         cout << " (Distance: " << (path.size() - 1) << ")" << endl;
@@ -255,8 +1754,8 @@ public:
     
     void printAllUsers() {
         cout << "\n=== All Users ===" << endl;
-        for (const auto& pair : users) {
-            pair.second.printProfile();
+        for (int userId : snapshot().userIds) {
+            users.get(userId).printProfile();
         }
     }
 };
@@ -313,103 +1812,196 @@ void demonstrateSocialNetwork() {
     network.printUserConnections(1); // Alice
     network.printUserConnections(3); // Charlie
     
+    cout << "\n=== Batch Recommendations (top 2) ===" << endl;
+    vector<int> everyone = {1, 2, 3, 4, 5, 6};
+    vector<vector<int>> batch = network.recommendFriendsBatch(everyone, 2);
+    for (size_t i = 0; i < everyone.size(); i++) {
+        cout << "User " << everyone[i] << ":";
+        for (int userId : batch[i]) cout << " " << userId;
+        cout << endl;
+    }
+    
+    cout << "\n=== Interest Similarity (MinHash/LSH) ===" << endl;
+    for (auto [userId, similarity] : network.findSimilarUsers(1, 3)) {
+        cout << "Like Alice: " << network.userStore().name(userId) << " (~" << similarity << ")" << endl;
+    }
+    cout << "Hybrid recommendations for Alice:";
+    for (auto [userId, score] : network.recommendFriendsHybrid(1, 3)) {
+        cout << " " << userId << " (" << score << ")";
+    }
+    cout << endl;
+    
+    cout << "\n=== Attribute Filters ===" << endl;
+    cout << "In Texas and likes Sports:";
+    for (int userId : network.findUsers("Texas", "Sports")) cout << " " << userId;
+    cout << endl;
+    const UserStore& store = network.userStore();
+    cout << "Aged 25-30 and likes Photography:";
+    for (int userId : store.usersIn(UserStore::both(store.withAge(25, 30), store.withInterest("Photography")))) {
+        cout << " " << userId;
+    }
+    cout << endl;
+    
     cout << "\n=== Shortest Paths ===" << endl;
     network.printShortestPath(1, 3); // Alice -> Charlie
     network.printShortestPath(1, 5); // Alice -> Eve
     network.printShortestPath(2, 6); // Bob -> Frank
     
+    cout << "\n=== Removing Friendships ===" << endl;
+    network.removeFriendship(3, 6); // Charlie - Frank
+    cout << "Number of communities: " << network.findCommunities().size() << endl;
+    cout << "Alice and Frank in same community: "
+         << (network.inSameCommunity(1, 6) ? "yes" : "no") << endl;
+    network.addFriendship(5, 6); // Eve - Frank
+    cout << "Alice and Frank in same community: "
+         << (network.inSameCommunity(1, 6) ? "yes" : "no") << endl;
+    
     cout << "\n=== All Users ===" << endl;
     network.printAllUsers();
 }
 
+// Bulk loading demo: a quiet network fed from an edge list file
+void demonstrateBulkLoading() {
+    cout << "\n=== Bulk Loading ===" << endl;
+    string path = (filesystem::temp_directory_path() / "social_network_edges.txt").string();
+    ofstream(path) << "# user pairs\n1 2\n2 3\n3 1\n2 1\n4 5\n5 9\n6 6\n";
+    
+    SocialNetwork network;
+    network.setVerbose(false);
+    for (int id = 1; id <= 6; id++) {
+        network.addUser(User(id, "User" + to_string(id), 20 + id, "Texas"));
+    }
+    
+    SocialNetwork::LoadStats stats = network.loadEdges(path);
+    cout << "Edges read: " << stats.edgesRead << ", new: " << stats.edgesAdded
+         << ", skipped: " << stats.skipped << endl;
+    cout << "Number of communities: " << network.findCommunities().size() << endl;
+    network.printShortestPath(1, 3);
+    remove(path.c_str());
+}
+
 // Advanced graph algorithms
 class AdvancedSocialNetwork : public SocialNetwork {
 public:
-    // DFS to find all paths between two users
-    vector<vector<int>> findAllPaths(int from, int to) {
-        vector<vector<int>> allPaths;
-        vector<int> currentPath;
-        unordered_set<int> visited;
-        
-        dfsFindPaths(from, to, currentPath, visited, allPaths);
-        return allPaths;
-    }
+    // Default budgets for findAllPaths; the number of simple paths grows
+    // exponentially with length on any real graph
+    static constexpr int DEFAULT_MAX_HOPS = 6;
+    static constexpr size_t DEFAULT_MAX_PATHS = 1000;
     
-private:
-    void dfsFindPaths(int current, int target, vector<int>& currentPath, 
-                     unordered_set<int>& visited, vector<vector<int>>& allPaths) {
-        currentPath.push_back(current);
-        visited.insert(current);
+    // Streams simple paths from -> to with at most maxHops edges to
+    // callback(const vector<int>& path), which returns false to stop early.
+    // Stops after maxResults paths (0 for no limit) and returns how many were
+    // produced. An iterative DFS keeps one cursor per path vertex, so depth
+    // costs no call stack. A BFS from `to` gives every vertex a lower bound on
+    // its remaining hops, so any branch that cannot reach `to` within budget
+    // is cut before it is entered.
+    template<typename F>
+    size_t forEachPath(int from, int to, int maxHops, size_t maxResults, F callback) {
+        const CSRGraph& graph = snapshot();
+        int source = graph.toDense(from), target = graph.toDense(to);
+        if (source < 0 || target < 0 || maxHops < 0) return 0;
         
-        if (current == target) {
-            allPaths.push_back(currentPath);
-        } else {
-            for (int neighbor : adjacencyList[current]) {
-                if (visited.find(neighbor) == visited.end()) {
-                    dfsFindPaths(neighbor, target, currentPath, visited, allPaths);
-                }
-            }
+        vector<int> path = {from};
+        if (source == target) {
+            callback(path);
+            return 1;
         }
         
-        currentPath.pop_back();
-        visited.erase(current);
-    }
-    
-public:
-    // Find users within k degrees of separation
-    vector<int> findUsersWithinK(int userId, int k) {
-        if (users.find(userId) == users.end()) return {};
-        
-        queue<pair<int, int>> q; // {userId, distance}
-        unordered_set<int> visited;
-        vector<int> result;
+        // Hops to target, -1 when farther than maxHops
+        vector<int> distance(graph.vertexCount(), -1);
+        distance[target] = 0;
+        DirectionOptimizingBFS bfs(graph);
+        bfs.run(target, maxHops, [&](int depth, const vector<int>& level) {
+            for (int v : level) distance[v] = depth;
+        });
+        if (distance[source] < 0) return 0;
         
-        q.push({userId, 0});
-        visited.insert(userId);
+        vector<int> stack = {source};
+        vector<const int*> cursor = {graph.neighborsOf(source).begin()};
+        vector<bool> onPath(graph.vertexCount(), false);
+        onPath[source] = true;
+        size_t found = 0;
         
-        while (!q.empty()) {
-            auto [current, distance] = q.front();
-            q.pop();
-            
-            if (distance <= k && current != userId) {
-                result.push_back(current);
+        while (!stack.empty()) {
+            int current = stack.back();
+            if (cursor.back() == graph.neighborsOf(current).end()) {
+                onPath[current] = false;
+                stack.pop_back();
+                cursor.pop_back();
+                path.pop_back();
+                continue;
             }
             
-            if (distance < k) {
-                for (int neighbor : adjacencyList[current]) {
-                    if (visited.find(neighbor) == visited.end()) {
-                        visited.insert(neighbor);
-                        q.push({neighbor, distance + 1});
-                    }
-                }
+            int next = *cursor.back()++;
+            int hops = stack.size(); // edges on the path once next is appended
+            if (onPath[next] || distance[next] < 0 || hops + distance[next] > maxHops) continue;
+            
+            if (next == target) {
+                path.push_back(to);
+                found++;
+                bool more = callback(path);
+                path.pop_back();
+                if (!more || found == maxResults) break;
+                continue;
             }
+            
+            stack.push_back(next);
+            cursor.push_back(graph.neighborsOf(next).begin());
+            onPath[next] = true;
+            path.push_back(graph.toUser(next));
         }
         
-        return result;
+        return found;
     }
     
-    // Calculate clustering coefficient for a user
-    double calculateClusteringCoefficient(int userId) {
-        if (users.find(userId) == users.end()) return 0.0;
-        
-        vector<int> neighbors = adjacencyList[userId];
-        int n = neighbors.size();
+    // Materializes up to maxPaths simple paths of at most maxHops edges
+    vector<vector<int>> findAllPaths(int from, int to, int maxHops = DEFAULT_MAX_HOPS,
+                                     size_t maxPaths = DEFAULT_MAX_PATHS) {
+        vector<vector<int>> allPaths;
+        forEachPath(from, to, maxHops, maxPaths, [&](const vector<int>& path) {
+            allPaths.push_back(path);
+            return true;
+        });
+        return allPaths;
+    }
+    
+    // Find users within k degrees of separation, nearest first and by user
+    // ID within each distance
+    vector<int> findUsersWithinK(int userId, int k, int numThreads = 0) {
+        const CSRGraph& graph = snapshot();
+        int source = graph.toDense(userId);
+        if (source < 0 || k <= 0) return {};
         
-        if (n < 2) return 0.0;
+        vector<int> result;
+        DirectionOptimizingBFS bfs(graph, numThreads);
+        bfs.run(source, k, [&](int, const vector<int>& level) {
+            for (int v : level) result.push_back(graph.toUser(v));
+        });
         
-        int edges = 0;
-        for (int i = 0; i < n; i++) {
-            for (int j = i + 1; j < n; j++) {
-                if (find(adjacencyList[neighbors[i]].begin(), 
-                        adjacencyList[neighbors[i]].end(), 
-                        neighbors[j]) != adjacencyList[neighbors[i]].end()) {
-                    edges++;
-                }
-            }
+        return result;
+    }
+    
+    // Triangle counts and clustering coefficients for every user, computed
+    // in one parallel pass and reused until the graph changes
+    const ClusteringStats& clusteringStats(int numThreads = 0) {
+        const CSRGraph& graph = snapshot();
+        if (clusteringVersion != snapshotVersion) {
+            clustering = countTriangles(graph, numThreads);
+            clusteringVersion = snapshotVersion;
         }
-        
-        return (2.0 * edges) / (n * (n - 1));
+        return clustering;
+    }
+    
+    // Calculate clustering coefficient for a user
+    double calculateClusteringCoefficient(int userId) {
+        const ClusteringStats& stats = clusteringStats();
+        int v = snapshot().toDense(userId);
+        return v < 0 ? 0.0 : stats.local[v];
     }
+    
+private:
+    ClusteringStats clustering;
+    uint64_t clusteringVersion = 0;
 };
 
 int main() {
@@ -455,6 +2047,17 @@ int main() {
     double clusteringCoeff = advancedNetwork.calculateClusteringCoefficient(1);
     cout << "\nClustering coefficient for Alice: " << clusteringCoeff << endl;
     
+    // Bob - Diana closes two triangles
+    advancedNetwork.addFriendship(2, 4);
+    const ClusteringStats& stats = advancedNetwork.clusteringStats();
+    cout << "Clustering coefficient for Alice: "
+         << advancedNetwork.calculateClusteringCoefficient(1) << endl;
+    cout << "Triangles: " << stats.totalTriangles
+         << ", global clustering: " << stats.globalCoefficient
+         << ", average clustering: " << stats.averageCoefficient << endl;
+    
+    demonstrateBulkLoading();
+    
     return 0;
 }
 
@@ -475,6 +2078,8 @@ Added friendship: Alice <-> Diana
 Added friendship: Diana <-> Eve
 Added friendship: Charlie <-> Frank
 
+=== Network Analysis ===
+
 === Network Statistics ===
 Total users: 6
 Total connections: 6
@@ -485,6 +2090,7 @@ Number of communities: 1
 Community 1: Alice, Bob, Charlie, Diana, Eve, Frank
 
 === User Connections ===
+
 === Connections for Alice ===
 Direct friends (2): Bob, Diana
 Friend recommendations: Charlie, Eve
@@ -493,16 +2099,73 @@ Friend recommendations: Charlie, Eve
 Direct friends (3): Bob, Diana, Frank
 Friend recommendations: Alice, Eve
 
+=== Batch Recommendations (top 2) ===
+User 1: 3 5
+User 2: 4 6
+User 3: 1 5
+User 4: 2 6
+User 5: 3 1
+User 6: 4 2
+
+=== Interest Similarity (MinHash/LSH) ===
+Like Alice: Diana (~0.34375)
+Like Alice: Eve (~0.265625)
+Hybrid recommendations for Alice: 3 (2) 5 (1.26562)
+
+=== Attribute Filters ===
+In Texas and likes Sports: 3
+Aged 25-30 and likes Photography: 1 4
+
 === Shortest Paths ===
 Shortest path from Alice to Charlie: Alice -> Bob -> Charlie (Distance: 2)
 Shortest path from Alice to Eve: Alice -> Diana -> Eve (Distance: 2)
 Shortest path from Bob to Frank: Bob -> Charlie -> Frank (Distance: 2)
 
+=== Removing Friendships ===
+Removed friendship: Charlie <-> Frank
+Number of communities: 2
+Alice and Frank in same community: no
+Added friendship: Eve <-> Frank
+Alice and Frank in same community: yes
+
+=== All Users ===
+
 === All Users ===
 User 1: Alice (Age: 25, Location: New York) - Interests: Photography, Travel
 User 2: Bob (Age: 30, Location: California) - Interests: Technology, Gaming
 User 3: Charlie (Age: 28, Location: Texas) - Interests: Music, Sports
-User 4: Diana (Age: 26, Location: Florida) - Interests: Art, Photography
-User 5: Eve (Age: 24, Location: Washington) - Interests: Books, Travel
-User 6: Frank (Age: 32, Location: Oregon) - Interests: Sports, Technology
+User 4: Diana (Age: 26, Location: Florida) - Interests: Photography, Art
+User 5: Eve (Age: 24, Location: Washington) - Interests: Travel, Books
+User 6: Frank (Age: 32, Location: Oregon) - Interests: Technology, Sports
+
+==================================================
+Advanced Graph Algorithms Demo
+==================================================
+Added user: Alice (ID: 1)
+Added user: Bob (ID: 2)
+Added user: Charlie (ID: 3)
+Added user: Diana (ID: 4)
+Added friendship: Alice <-> Bob
+Added friendship: Bob <-> Charlie
+Added friendship: Charlie <-> Diana
+Added friendship: Alice <-> Diana
+
+All paths from Alice to Charlie:
+User 1 -> User 2 -> User 3
+User 1 -> User 4 -> User 3
+
+Users within 2 degrees of Alice:
+User 2
+User 4
+User 3
+
+Clustering coefficient for Alice: 0
+Added friendship: Bob <-> Diana
+Clustering coefficient for Alice: 1
+Triangles: 2, global clustering: 0.75, average clustering: 0.833333
+
+=== Bulk Loading ===
+Edges read: 7, new: 4, skipped: 2
+Number of communities: 3
+Shortest path from User1 to User3: User1 -> User3 (Distance: 1)
 */
@@ -1,5 +1,12 @@
 #pragma once
 #include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 using namespace std;
 
 // Type definitions for convenience
@@ -79,6 +86,68 @@ struct min_heap {
     }
 };
 
+// Parallel loops
+// Starting a thread costs tens of microseconds, so parallel code asks
+// threadsFor() how many threads its work is worth: no more than requested,
+// and few enough that each one gets at least minWorkPerThread units of work.
+// Below that, spawning the thread costs more than it saves.
+
+// numThreads <= 0 means one per hardware thread
+int resolveThreads(int numThreads) {
+    return numThreads > 0 ? numThreads : max(1u, thread::hardware_concurrency());
+}
+
+int threadsFor(int numThreads, size_t work, size_t minWorkPerThread) {
+    return max<size_t>(1, min<size_t>(resolveThreads(numThreads), work / minWorkPerThread));
+}
+
+// Runs f(0) .. f(numThreads - 1) on their own threads (inline for one)
+template<typename F>
+void parallelFor(int numThreads, F f) {
+    if (numThreads == 1) {
+        f(0);
+        return;
+    }
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; t++) workers.emplace_back(f, t);
+    for (thread& worker : workers) worker.join();
+}
+
+// Read-only memory mapping of a whole file, unmapped on destruction
+// An empty file opens successfully with size 0. advice goes to madvise,
+// e.g. MADV_SEQUENTIAL for a single front-to-back scan.
+class MappedFile {
+    void* addr = MAP_FAILED;
+    size_t length = 0;
+    
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        if (addr != MAP_FAILED) munmap(addr, length);
+    }
+    
+    bool open(const string& path, int advice = MADV_NORMAL) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        if (ok && st.st_size > 0) {
+            length = st.st_size;
+            addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = addr != MAP_FAILED;
+            if (ok && advice != MADV_NORMAL) madvise(addr, length, advice);
+        }
+        close(fd);
+        return ok;
+    }
+    
+    const char* data() const { return length ? (const char*)addr : nullptr; }
+    size_t size() const { return length; }
+};
+
 // Union-Find (Disjoint Set Union)
 class UnionFind {
     vector<int> parent, rank;
@@ -87,11 +156,14 @@ public:
         iota(parent.begin(), parent.end(), 0);
     }
     
+    // Iterative path halving: every visited node skips to its grandparent,
+    // so long chains cannot overflow the stack
     int find(int x) {
-        if (parent[x] != x) {
-            parent[x] = find(parent[x]);
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
         }
-        return parent[x];
+        return x;
     }
     
     void unite(int x, int y) {
@@ -107,6 +179,54 @@ public:
     }
 };
 
+// Lock-free Union-Find for concurrent unite/find from many threads
+// A root is linked under the other root by a single CAS on its parent word.
+// The larger index always goes under the smaller, so parents only decrease
+// and no cycle can form. find does path halving with CAS; a failed CAS only
+// means another thread already moved the pointer higher up the same tree.
+class ConcurrentUnionFind {
+    vector<atomic<int>> parent;
+public:
+    ConcurrentUnionFind(int n) : parent(n) {
+        for (int i = 0; i < n; i++) parent[i].store(i, memory_order_relaxed);
+    }
+    
+    int find(int x) {
+        while (true) {
+            int p = parent[x].load(memory_order_relaxed);
+            if (p == x) return x;
+            int g = parent[p].load(memory_order_relaxed);
+            if (p != g) parent[x].compare_exchange_weak(p, g, memory_order_relaxed);
+            x = g;
+        }
+    }
+    
+    // Returns true if this call merged two different sets
+    bool unite(int x, int y) {
+        while (true) {
+            x = find(x);
+            y = find(y);
+            if (x == y) return false;
+            if (x < y) swap(x, y);
+            int expected = x;
+            if (parent[x].compare_exchange_strong(expected, y, memory_order_acq_rel)) return true;
+        }
+    }
+    
+    // A concurrent unite can make x stop being a root between the two finds,
+    // so a "no" answer is only final once x is confirmed to still be a root
+    bool connected(int x, int y) {
+        while (true) {
+            x = find(x);
+            y = find(y);
+            if (x == y) return true;
+            if (parent[x].load(memory_order_relaxed) == x) return false;
+        }
+    }
+    
+    int size() const { return parent.size(); }
+};
+
 // Segment Tree (for range queries)
 class SegmentTree {
     vector<int> tree;
@@ -188,54 +308,466 @@ public:
     }
 };
 
+// Succinct Bit Vector
+// Append-only bits with a rank directory (ones before each 64-bit word) and the
+// word holding every 64th zero, for O(1) rank and near-O(1) select of zeros.
+// Call build() after the last push.
+class BitVector {
+    static constexpr size_t ZERO_SAMPLE = 64;
+    
+    vector<uint64_t> words;
+    vector<uint32_t> ranks;       // ones before each word, plus a total
+    vector<uint32_t> zeroSamples; // word holding zero number i * ZERO_SAMPLE
+    size_t length = 0;
+    
+public:
+    void push(bool bit) {
+        if (length % 64 == 0) words.push_back(0);
+        if (bit) words.back() |= 1ull << (length % 64);
+        length++;
+    }
+    
+    void build() {
+        words.shrink_to_fit();
+        ranks.assign(words.size() + 1, 0);
+        zeroSamples.clear();
+        size_t zeros = 0;
+        for (size_t w = 0; w < words.size(); w++) {
+            size_t bits = min<size_t>(64, length - w * 64);
+            size_t wordZeros = bits - __builtin_popcountll(words[w]);
+            // Every sampled zero index that falls in this word
+            while (zeroSamples.size() * ZERO_SAMPLE < zeros + wordZeros) zeroSamples.push_back(w);
+            zeros += wordZeros;
+            ranks[w + 1] = ranks[w] + __builtin_popcountll(words[w]);
+        }
+        zeroSamples.shrink_to_fit();
+    }
+    
+    bool operator[](size_t i) const { return words[i / 64] >> (i % 64) & 1; }
+    size_t size() const { return length; }
+    
+    // Ones in [0, i)
+    size_t rank1(size_t i) const {
+        size_t w = i / 64, bit = i % 64;
+        return ranks[w] + (bit ? __builtin_popcountll(words[w] << (64 - bit)) : 0);
+    }
+    
+    size_t rank0(size_t i) const { return i - rank1(i); }
+    
+    // Position of zero number k (0-based); k must be below rank0(size())
+    size_t select0(size_t k) const {
+        size_t w = zeroSamples[k / ZERO_SAMPLE];
+        while (w + 1 < words.size() && (w + 1) * 64 - ranks[w + 1] <= k) w++;
+        return w * 64 + selectInWord(~words[w], k - (w * 64 - ranks[w]));
+    }
+    
+    // First zero at or after position i (one must exist)
+    size_t nextZero(size_t i) const {
+        size_t w = i / 64;
+        uint64_t zeros = ~words[w] & (~0ull << (i % 64));
+        while (!zeros) zeros = ~words[++w];
+        return w * 64 + __builtin_ctzll(zeros);
+    }
+    
+    size_t memoryUsage() const {
+        return words.capacity() * sizeof(uint64_t) +
+               (ranks.capacity() + zeroSamples.capacity()) * sizeof(uint32_t);
+    }
+    
+private:
+    // Position of set bit number r in x. Byte popcounts are prefix-summed with
+    // one multiply, a parallel compare finds the byte holding the bit, and the
+    // few bits below it in that byte are cleared one by one.
+    static size_t selectInWord(uint64_t x, size_t r) {
+        const uint64_t ones = 0x0101010101010101ull, highs = 0x8080808080808080ull;
+        uint64_t sums = x - (x >> 1 & 0x5555555555555555ull);
+        sums = (sums & 0x3333333333333333ull) + (sums >> 2 & 0x3333333333333333ull);
+        sums = ((sums + (sums >> 4)) & 0x0F0F0F0F0F0F0F0Full) * ones;
+        
+        // High bit of each byte set where the inclusive prefix sum is <= r
+        uint64_t below = ((r * ones | highs) - sums) & highs;
+        size_t shift = __builtin_popcountll(below) * 8;
+        r -= (sums << 8) >> shift & 0xFF;
+        
+        uint64_t bits = x >> shift;
+        for (; r > 0; r--) bits &= bits - 1;
+        return shift + __builtin_ctzll(bits);
+    }
+};
+
 // Trie Node
+// Byte-level node (any byte, so UTF-8 words work as-is) whose children are
+// stored according to its fan-out, as in an adaptive radix tree:
+// - one child (most nodes): its byte and index sit in the node itself;
+// - up to 16: a block in the trie's slot pool with the sorted key bytes, then
+//   the child indexes (Node4/Node16), found by one SIMD compare;
+// - more: a block with a 256-bit presence bitmap, the number of children
+//   before each bitmap word, then the child indexes; the child for byte b is
+//   its rank, one popcount away (Node48/Node256).
+// Keys and children share one block, so a step usually touches one cache line.
 struct TrieNode {
-    TrieNode* children[26];
+    uint32_t firstChild; // the only child, or the offset of the node's block
+    uint16_t count;      // number of children
+    uint8_t key;         // byte of the only child
     bool isEnd;
-    TrieNode() : isEnd(false) {
-        for (int i = 0; i < 26; i++) {
-            children[i] = nullptr;
-        }
-    }
+    TrieNode() : firstChild(0), count(0), key(0), isEnd(false) {}
 };
 
-// Trie Class
+// Trie Class (arena-backed)
+// Nodes live in one vector and refer to each other by 32-bit index; child
+// blocks live in a shared slot pool and grow in power-of-two steps, with
+// outgrown blocks recycled. Everything is released in one shot when the trie
+// is destroyed or cleared. A trie can also borrow its node and slot arrays
+// read-only (e.g. from a memory-mapped file).
+// freeze() turns a finished trie into a read-only LOUDS encoding: nodes are
+// numbered in BFS order and the tree shape is one bit vector holding, per
+// node, a 1 for each child followed by a 0. A node's children then have
+// consecutive IDs starting at select0(v) - v, and only their edge bytes and
+// end-of-word bits are stored, about 2 bytes per node in total.
 class Trie {
-    TrieNode* root;
+    static constexpr int SMALL = 16;       // most children a sorted-key node holds
+    static constexpr int BITMAP_WORDS = 8; // 256-bit presence bitmap of a wide node
+    static constexpr int WIDE_HEADER = BITMAP_WORDS + 2; // bitmap, then 8 byte-sized ranks
+    static constexpr int SIZE_CLASSES = 9; // capacity 2..16 sorted, 32..256 bitmap
+    
+    vector<TrieNode> nodes;
+    vector<uint32_t> slots;
+    vector<uint32_t> freeBlocks[SIZE_CLASSES];
+    const TrieNode* borrowedNodes = nullptr;
+    const uint32_t* borrowedSlots = nullptr;
+    size_t borrowedCount = 0;
+    
+    // Frozen (LOUDS) form
+    bool frozen = false;
+    BitVector louds;          // "10" for a virtual super-root, then 1^children 0 per node
+    BitVector terminals;      // isEnd per node
+    vector<uint8_t> labels;   // byte on the edge into each node
     
 public:
-    Trie() : root(new TrieNode()) {}
+    static constexpr uint32_t ROOT = 0;
+    static constexpr uint32_t NONE = UINT32_MAX;
+    
+    Trie() : nodes(1) {}
+    
+    // Read-only trie over arrays produced by nodeData()/slotData()
+    Trie(const TrieNode* nodes, size_t nodeCount, const uint32_t* slots)
+        : borrowedNodes(nodes), borrowedSlots(slots), borrowedCount(nodeCount) {}
     
-    void insert(string word) {
-        TrieNode* node = root;
+    // Returns the index of the node that terminates the word
+    uint32_t insert(string_view word) {
+        assert(!borrowedNodes && !frozen);
+        uint32_t node = ROOT;
         for (char c : word) {
-            int index = c - 'a';
-            if (!node->children[index]) {
-                node->children[index] = new TrieNode();
+            uint32_t next = child(node, c);
+            if (next == NONE) next = addChild(node, c);
+            node = next;
+        }
+        nodes[node].isEnd = true;
+        return node;
+    }
+    
+    bool search(const string& word) const {
+        uint32_t node = walk(word);
+        return node != NONE && isEnd(node);
+    }
+    
+    bool startsWith(const string& prefix) const {
+        return walk(prefix) != NONE;
+    }
+    
+    vector<string> getSuggestions(const string& prefix) const {
+        vector<string> result;
+        uint32_t node = walk(prefix);
+        if (node == NONE) return result;
+        
+        string word = prefix;
+        collectWords(node, word, result);
+        return result;
+    }
+    
+    // Words within maxDistance edits (insert, delete, substitute) of word, as
+    // (word, distance) ordered by distance, then alphabetically. Carries one
+    // Levenshtein DP row per trie depth and prunes every subtree whose row
+    // minimum already exceeds maxDistance, so only a thin band is visited.
+    vector<pair<string, int>> fuzzySearch(string_view word, int maxDistance) const {
+        vector<pair<string, int>> result;
+        if (maxDistance < 0) return result;
+        
+        vector<int> rows(word.size() + 1);
+        iota(rows.begin(), rows.end(), 0);
+        string prefix;
+        collectFuzzy(ROOT, word, maxDistance, rows, prefix, result);
+        
+        sort(result.begin(), result.end(), [](const pair<string, int>& a, const pair<string, int>& b) {
+            return a.second != b.second ? a.second < b.second : a.first < b.first;
+        });
+        return result;
+    }
+    
+    // Node-level access for callers that attach data to nodes by index
+    uint32_t walk(string_view s, uint32_t node = ROOT) const {
+        for (char c : s) {
+            node = child(node, c);
+            if (node == NONE) return NONE;
+        }
+        return node;
+    }
+    
+    uint32_t child(uint32_t node, char c) const {
+        uint8_t b = c;
+        if (frozen) {
+            size_t start = louds.select0(node);
+            size_t first = start - node, count = louds.nextZero(start + 1) - start - 1;
+            const uint8_t* label = labels.data() + first;
+            size_t i = lower_bound(label, label + count, b) - label;
+            return i < count && label[i] == b ? first + i : NONE;
+        }
+        
+        const TrieNode& n = nodeData()[node];
+        if (n.count <= 1) return n.count == 1 && n.key == b ? n.firstChild : NONE;
+        
+        const uint32_t* block = slotData() + n.firstChild;
+        
+        if (n.count <= SMALL) {
+            const uint8_t* key = (const uint8_t*)block;
+            const uint32_t* children = block + keyWords(n.count);
+#ifdef __SSE2__
+            if (n.count > 4) {
+                // The block holds 8 or 16 key bytes, so the load stays inside it
+                __m128i keys = n.count > 8 ? _mm_loadu_si128((const __m128i*)key)
+                                           : _mm_loadl_epi64((const __m128i*)key);
+                uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(keys, _mm_set1_epi8(c)));
+                mask &= (1u << n.count) - 1;
+                return mask ? children[__builtin_ctz(mask)] : NONE;
+            }
+#endif
+            for (int i = 0; i < n.count; i++) {
+                if (key[i] == b) return children[i];
             }
-            node = node->children[index];
+            return NONE;
         }
-        node->isEnd = true;
+        
+        uint32_t word = block[b >> 5], bit = 1u << (b & 31);
+        if (!(word & bit)) return NONE;
+        const uint8_t* ranks = (const uint8_t*)(block + BITMAP_WORDS);
+        return block[WIDE_HEADER + ranks[b >> 5] + __builtin_popcount(word & (bit - 1))];
     }
     
-    bool search(string word) {
-        TrieNode* node = root;
-        for (char c : word) {
-            int index = c - 'a';
-            if (!node->children[index]) return false;
-            node = node->children[index];
+    // Calls f(byte, childIndex) for each child in byte order (code point
+    // order for UTF-8)
+    template<typename F>
+    void forEachChild(uint32_t node, F f) const {
+        if (frozen) {
+            size_t start = louds.select0(node);
+            size_t first = start - node, count = louds.nextZero(start + 1) - start - 1;
+            for (size_t i = first; i < first + count; i++) f(char(labels[i]), uint32_t(i));
+            return;
+        }
+        
+        const TrieNode& n = nodeData()[node];
+        if (n.count == 1) f(char(n.key), n.firstChild);
+        if (n.count <= 1) return;
+        
+        const uint32_t* block = slotData() + n.firstChild;
+        if (n.count <= SMALL) {
+            const uint8_t* key = (const uint8_t*)block;
+            const uint32_t* children = block + keyWords(n.count);
+            for (int i = 0; i < n.count; i++) f(char(key[i]), children[i]);
+            return;
+        }
+        
+        const uint32_t* child = block + WIDE_HEADER;
+        for (int w = 0; w < BITMAP_WORDS; w++) {
+            for (uint32_t m = block[w]; m; m &= m - 1) {
+                f(char(w * 32 + __builtin_ctz(m)), *child++);
+            }
         }
-        return node->isEnd;
     }
     
-    bool startsWith(string prefix) {
-        TrieNode* node = root;
-        for (char c : prefix) {
-            int index = c - 'a';
-            if (!node->children[index]) return false;
-            node = node->children[index];
+    bool isEnd(uint32_t node) const { return frozen ? terminals[node] : nodeData()[node].isEnd; }
+    size_t size() const { return frozen ? labels.size() : borrowedNodes ? borrowedCount : nodes.size(); }
+    bool isFrozen() const { return frozen; }
+    
+    // Converts the trie to its LOUDS form and releases the arena. Node IDs
+    // change to BFS order; the result maps each old ID to its new one so
+    // callers can move any data they keep per node. Inserting afterwards is
+    // not allowed (clear() makes the trie mutable again).
+    vector<uint32_t> freeze() {
+        assert(!frozen);
+        vector<uint32_t> remap(size(), NONE);
+        vector<uint32_t> order = {ROOT};
+        BitVector shape, ends;
+        vector<uint8_t> edge = {0};
+        shape.push(1);
+        shape.push(0);
+        
+        for (size_t i = 0; i < order.size(); i++) {
+            remap[order[i]] = i;
+            ends.push(isEnd(order[i]));
+            forEachChild(order[i], [&](char c, uint32_t next) {
+                order.push_back(next);
+                edge.push_back(c);
+                shape.push(1);
+            });
+            shape.push(0);
         }
-        return true;
+        
+        edge.shrink_to_fit();
+        shape.build();
+        ends.build();
+        clear();
+        vector<TrieNode>().swap(nodes);
+        vector<uint32_t>().swap(slots);
+        louds = move(shape);
+        terminals = move(ends);
+        labels = move(edge);
+        frozen = true;
+        return remap;
+    }
+    
+    // Bytes used by whichever form the trie is in (0 for borrowed arrays)
+    size_t memoryUsage() const {
+        if (frozen) return louds.memoryUsage() + terminals.memoryUsage() + labels.capacity();
+        size_t bytes = nodes.capacity() * sizeof(TrieNode) + slots.capacity() * sizeof(uint32_t);
+        for (const auto& blocks : freeBlocks) bytes += blocks.capacity() * sizeof(uint32_t);
+        return bytes;
+    }
+    
+    const TrieNode* nodeData() const { return borrowedNodes ? borrowedNodes : nodes.data(); }
+    const uint32_t* slotData() const { return borrowedNodes ? borrowedSlots : slots.data(); }
+    size_t slotCount() const { return slots.size(); }
+    
+    void clear() {
+        borrowedNodes = nullptr;
+        borrowedSlots = nullptr;
+        frozen = false;
+        louds = BitVector();
+        terminals = BitVector();
+        labels.clear();
+        nodes.assign(1, TrieNode());
+        slots.clear();
+        for (auto& blocks : freeBlocks) blocks.clear();
+    }
+    
+private:
+    // Slots taken by the key bytes of a small node (its capacity, rounded up to words)
+    static int keyWords(int count) {
+        return count <= 4 ? 1 : count <= 8 ? 2 : 4;
+    }
+    
+    // Capacity 2^k; a small block also holds its keys, a wide one its bitmap and ranks
+    static uint32_t blockSize(int sizeClass) {
+        uint32_t capacity = 1u << sizeClass;
+        return capacity <= SMALL ? capacity + keyWords(capacity) : WIDE_HEADER + capacity;
+    }
+    
+    // Size class of the block a node with count (>= 2) children lives in
+    static int sizeClassFor(int count) {
+        int sizeClass = 32 - __builtin_clz(count - 1); // ceil(log2(count))
+        return count <= SMALL ? sizeClass : max(sizeClass, 5);
+    }
+    
+    uint32_t addChild(uint32_t node, char c) {
+        uint32_t id = nodes.size();
+        nodes.emplace_back();
+        
+        uint8_t key[256];
+        uint32_t child[256];
+        int count = 0;
+        forEachChild(node, [&](char k, uint32_t next) {
+            key[count] = k;
+            child[count++] = next;
+        });
+        
+        uint8_t b = c;
+        int rank = lower_bound(key, key + count, b) - key;
+        for (int i = count; i > rank; i--) {
+            key[i] = key[i - 1];
+            child[i] = child[i - 1];
+        }
+        key[rank] = b;
+        child[rank] = id;
+        
+        TrieNode& n = nodes[node];
+        n.count = count + 1;
+        if (count == 0) {
+            n.key = b;
+            n.firstChild = id;
+            return id;
+        }
+        
+        int newClass = sizeClassFor(count + 1);
+        if (count == 1) {
+            n.firstChild = allocBlock(newClass);
+        } else if (newClass != sizeClassFor(count)) {
+            freeBlocks[sizeClassFor(count)].push_back(n.firstChild);
+            n.firstChild = allocBlock(newClass);
+        }
+        
+        uint32_t* block = &slots[n.firstChild];
+        if (n.count <= SMALL) {
+            copy(key, key + n.count, (uint8_t*)block);
+            copy(child, child + n.count, block + keyWords(n.count));
+        } else {
+            fill(block, block + BITMAP_WORDS, 0);
+            for (int i = 0; i < n.count; i++) block[key[i] / 32] |= 1u << (key[i] % 32);
+            uint8_t* ranks = (uint8_t*)(block + BITMAP_WORDS);
+            for (int w = 0, before = 0; w < BITMAP_WORDS; w++) {
+                ranks[w] = before;
+                before += __builtin_popcount(block[w]);
+            }
+            copy(child, child + n.count, block + WIDE_HEADER);
+        }
+        return id;
+    }
+    
+    uint32_t allocBlock(int sizeClass) {
+        vector<uint32_t>& blocks = freeBlocks[sizeClass];
+        if (!blocks.empty()) {
+            uint32_t block = blocks.back();
+            blocks.pop_back();
+            return block;
+        }
+        uint32_t block = slots.size();
+        slots.resize(block + blockSize(sizeClass));
+        return block;
+    }
+    
+    // rows holds the DP row of every node on the path; prefix.size() is the depth
+    void collectFuzzy(uint32_t node, string_view word, int maxDistance, vector<int>& rows,
+                      string& prefix, vector<pair<string, int>>& result) const {
+        size_t width = word.size() + 1;
+        size_t row = prefix.size() * width;
+        if (isEnd(node) && rows[row + width - 1] <= maxDistance) {
+            result.push_back({prefix, rows[row + width - 1]});
+        }
+        
+        rows.resize(row + 2 * width);
+        forEachChild(node, [&](char c, uint32_t next) {
+            const int* prev = &rows[row];
+            int* cur = &rows[row + width];
+            cur[0] = prev[0] + 1;
+            int best = cur[0];
+            for (size_t i = 1; i < width; i++) {
+                cur[i] = min({prev[i] + 1, cur[i - 1] + 1, prev[i - 1] + (word[i - 1] != c)});
+                best = min(best, cur[i]);
+            }
+            if (best > maxDistance) return;
+            
+            prefix.push_back(c);
+            collectFuzzy(next, word, maxDistance, rows, prefix, result);
+            prefix.pop_back();
+        });
+    }
+    
+    void collectWords(uint32_t node, string& word, vector<string>& result) const {
+        if (isEnd(node)) result.push_back(word);
+        
+        forEachChild(node, [&](char c, uint32_t next) {
+            word.push_back(c);
+            collectWords(next, word, result);
+            word.pop_back();
+        });
     }
 };
 